@@ -0,0 +1,260 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <random>
+#include <fstream>
+#include <filesystem>
+#include <cstdlib>
+#include <new>
+#include "../include/block.h"
+#include "../include/transaction.h"
+#include "../include/utils.h"
+#include "../include/sha256.h"
+
+namespace fs = std::filesystem;
+using ahmiyat::utils::Sha256Backend;
+
+// Every heap allocation in the process is counted so each benchmark can
+// report allocations per operation
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+struct BenchResult {
+    double nsPerOp;
+    double mbPerSec;
+    double allocsPerOp;
+};
+
+// Keeps results observable so the optimizer cannot drop the work
+volatile uint8_t g_sink;
+
+void consume(const Hash256& hash) {
+    g_sink = g_sink ^ hash.data()[0];
+}
+
+/**
+ * @brief Time an operation, doubling the iteration count until a run lasts minSeconds
+ * @param op Operation to measure
+ * @param bytesPerOp Bytes processed per call, 0 if throughput is meaningless
+ * @param minSeconds Minimum duration of the measured run
+ * @return Per-operation timings and allocation count
+ */
+template <typename F>
+BenchResult measure(F&& op, size_t bytesPerOp, double minSeconds) {
+    // Warm caches and let the backend selection happen outside the timed region
+    op();
+
+    uint64_t iterations = 1;
+    while (true) {
+        uint64_t allocsBefore = g_allocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            op();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t allocs = g_allocations.load(std::memory_order_relaxed) - allocsBefore;
+
+        if (seconds >= minSeconds || iterations >= (1ull << 40)) {
+            BenchResult result;
+            result.nsPerOp = seconds * 1e9 / iterations;
+            result.mbPerSec = bytesPerOp > 0 ? (bytesPerOp * iterations) / seconds / 1e6 : 0.0;
+            result.allocsPerOp = static_cast<double>(allocs) / iterations;
+            return result;
+        }
+
+        iterations *= 2;
+    }
+}
+
+void printHeader() {
+    std::cout << std::left << std::setw(8) << "backend"
+              << std::setw(36) << "benchmark"
+              << std::right << std::setw(16) << "ns/op"
+              << std::setw(12) << "MB/s"
+              << std::setw(12) << "allocs/op" << std::endl;
+}
+
+void printResult(Sha256Backend backend, const std::string& name, const BenchResult& result) {
+    std::cout << std::left << std::setw(8) << ahmiyat::utils::sha256BackendName(backend)
+              << std::setw(36) << name
+              << std::right << std::fixed
+              << std::setw(16) << std::setprecision(1) << result.nsPerOp
+              << std::setw(12) << std::setprecision(1) << result.mbPerSec
+              << std::setw(12) << std::setprecision(2) << result.allocsPerOp << std::endl;
+}
+
+std::string sizeLabel(size_t bytes) {
+    if (bytes >= 1024 * 1024) return std::to_string(bytes / (1024 * 1024)) + " MiB";
+    if (bytes >= 1024) return std::to_string(bytes / 1024) + " KiB";
+    return std::to_string(bytes) + " B";
+}
+
+std::string randomBytes(size_t length, std::mt19937_64& rng) {
+    std::string data(length, '\0');
+    for (char& c : data) {
+        c = static_cast<char>(rng());
+    }
+    return data;
+}
+
+std::vector<Transaction> makeTransactions(size_t count) {
+    std::vector<Transaction> transactions;
+    transactions.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        transactions.emplace_back("sender_" + std::to_string(i), "recipient_" + std::to_string(i), 1.0 + i);
+    }
+    return transactions;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--min-time seconds] [--backend scalar|sha-ni]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double minSeconds = 0.5;
+    std::vector<Sha256Backend> backends;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--min-time" && i + 1 < argc) {
+            minSeconds = std::atof(argv[++i]);
+        } else if (arg == "--backend" && i + 1 < argc) {
+            std::string name = argv[++i];
+            bool found = false;
+            for (Sha256Backend backend : {Sha256Backend::SCALAR, Sha256Backend::SHA_NI}) {
+                if (name == ahmiyat::utils::sha256BackendName(backend)) {
+                    backends.push_back(backend);
+                    found = true;
+                }
+            }
+            if (!found) {
+                std::cerr << "Unknown backend: " << name << std::endl;
+                return 1;
+            }
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (backends.empty()) {
+        for (Sha256Backend backend : {Sha256Backend::SCALAR, Sha256Backend::SHA_NI}) {
+            if (ahmiyat::utils::sha256BackendSupported(backend)) {
+                backends.push_back(backend);
+            }
+        }
+    }
+
+    std::mt19937_64 rng(42);
+
+    // Message inputs for the in-memory hash
+    const std::vector<size_t> messageSizes = {32, 64, 256, 1024, 4096, 64 * 1024, 1024 * 1024};
+    std::vector<std::string> messages;
+    for (size_t size : messageSizes) {
+        messages.push_back(randomBytes(size, rng));
+    }
+
+    // File inputs; these are read back from the page cache after the first pass
+    const std::vector<size_t> fileSizes = {1, 10, 50};
+    std::vector<std::string> filePaths;
+    fs::path tempDir = fs::temp_directory_path();
+    for (size_t megabytes : fileSizes) {
+        fs::path path = tempDir / ("ahmiyat_bench_" + std::to_string(megabytes) + "mb.bin");
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Failed to create benchmark file: " << path << std::endl;
+            return 1;
+        }
+        for (size_t i = 0; i < megabytes; ++i) {
+            std::string chunk = randomBytes(1024 * 1024, rng);
+            file.write(chunk.data(), chunk.size());
+        }
+        filePaths.push_back(path.string());
+    }
+
+    // Blocks of different sizes and a single transfer
+    const std::vector<size_t> blockSizes = {0, 100, 1000};
+    std::vector<Block> blocks;
+    for (size_t count : blockSizes) {
+        blocks.emplace_back(1, makeTransactions(count), Hash256());
+    }
+    Transaction transaction("sender", "recipient", 12.5);
+
+    Sha256Backend originalBackend = ahmiyat::utils::sha256GetBackend();
+    printHeader();
+
+    for (Sha256Backend backend : backends) {
+        if (!ahmiyat::utils::sha256SetBackend(backend)) {
+            std::cerr << "Backend not supported on this CPU: " << ahmiyat::utils::sha256BackendName(backend) << std::endl;
+            continue;
+        }
+
+        for (size_t i = 0; i < messages.size(); ++i) {
+            const std::string& message = messages[i];
+            BenchResult result = measure([&]() {
+                consume(ahmiyat::utils::sha256Digest(message));
+            }, message.size(), minSeconds);
+            printResult(backend, "sha256Digest " + sizeLabel(message.size()), result);
+        }
+
+        for (size_t i = 0; i < messages.size(); ++i) {
+            const std::string& message = messages[i];
+            BenchResult result = measure([&]() {
+                g_sink = g_sink ^ static_cast<uint8_t>(ahmiyat::utils::sha256(message)[0]);
+            }, message.size(), minSeconds);
+            printResult(backend, "sha256 (hex) " + sizeLabel(message.size()), result);
+        }
+
+        for (size_t i = 0; i < filePaths.size(); ++i) {
+            const std::string& path = filePaths[i];
+            BenchResult result = measure([&]() {
+                consume(ahmiyat::utils::sha256FileDigest(path));
+            }, fileSizes[i] * 1024 * 1024, minSeconds);
+            printResult(backend, "sha256File " + std::to_string(fileSizes[i]) + " MB", result);
+        }
+
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            const Block& block = blocks[i];
+            BenchResult result = measure([&]() {
+                consume(block.calculateHash());
+            }, 0, minSeconds);
+            printResult(backend, "Block::calculateHash " + std::to_string(blockSizes[i]) + " txs", result);
+        }
+
+        BenchResult result = measure([&]() {
+            consume(transaction.calculateHash());
+        }, 0, minSeconds);
+        printResult(backend, "Transaction::calculateHash", result);
+    }
+
+    ahmiyat::utils::sha256SetBackend(originalBackend);
+
+    for (const auto& path : filePaths) {
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+
+    return 0;
+}
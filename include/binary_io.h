@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "hash256.h"
+
+namespace ahmiyat {
+namespace utils {
+
+/**
+ * @class BinaryWriter
+ * @brief Appends fields to a byte string for on-disk records
+ *
+ * Integers are fixed-width little-endian and strings carry a 32-bit length
+ * prefix, the same encoding Sha256 and HashPreimage use.
+ */
+class BinaryWriter {
+public:
+    void writeBytes(const void* data, size_t length) {
+        m_bytes.append(static_cast<const char*>(data), length);
+    }
+    void writeUint8(uint8_t value) { m_bytes.push_back(static_cast<char>(value)); }
+    void writeUint32(uint32_t value);
+    void writeUint64(uint64_t value);
+    void writeDouble(double value);
+    void writeString(const std::string& value);
+    void writeHash(const Hash256& hash) { writeBytes(hash.data(), Hash256::SIZE); }
+
+    void reserve(size_t length) { m_bytes.reserve(length); }
+    size_t size() const { return m_bytes.size(); }
+    const std::string& bytes() const { return m_bytes; }
+    std::string& bytes() { return m_bytes; }
+
+private:
+    std::string m_bytes;
+};
+
+/**
+ * @class BinaryReader
+ * @brief Reads fields written by BinaryWriter from a byte range
+ *
+ * Every read is bounds-checked; a read past the end fails and leaves the
+ * reader failed, so a caller can decode a whole record and check once.
+ */
+class BinaryReader {
+public:
+    BinaryReader(const uint8_t* data, size_t length) : m_data(data), m_length(length), m_position(0), m_failed(false) {}
+
+    bool readBytes(void* out, size_t length);
+    bool readUint8(uint8_t& value) { return readBytes(&value, 1); }
+    bool readUint32(uint32_t& value);
+    bool readUint64(uint64_t& value);
+    bool readDouble(double& value);
+    bool readString(std::string& value);
+    bool readHash(Hash256& hash) { return readBytes(hash.data(), Hash256::SIZE); }
+
+    size_t position() const { return m_position; }
+    size_t remaining() const { return m_length - m_position; }
+    bool failed() const { return m_failed; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_length;
+    size_t m_position;
+    bool m_failed;
+};
+
+/**
+ * @brief CRC-32 (IEEE 802.3) of a byte range
+ * @param data Bytes to checksum
+ * @param length Number of bytes
+ * @param crc Checksum of the preceding bytes, to continue a running checksum
+ * @return Checksum of everything fed so far
+ */
+uint32_t crc32(const void* data, size_t length, uint32_t crc = 0);
+
+} // namespace utils
+} // namespace ahmiyat
@@ -4,8 +4,15 @@
 #include <vector>
 #include <ctime>
 #include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <array>
+#include "hash256.h"
 #include "transaction.h"
 
+class MiningTelemetry;
+class BlockHeader;
+
 /**
  * @class Block
  * @brief Represents a block in the Ahmiyat blockchain
@@ -14,13 +21,46 @@
  */
 class Block {
 public:
+    /**
+     * Fixed binary header layout (integers little-endian):
+     *   [0, 4)   index
+     *   [4, 12)  timestamp
+     *   [12, 44) previous block hash
+     *   [44, 76) Merkle root of the transaction hashes
+     *   [76, 80) compact proof-of-work target
+     *   [80, 84) nonce
+     *   [84, 88) extra nonce
+     * The nonce lies in the second 64-byte SHA-256 block, so a miner can
+     * compress the first block once and pay one compression per nonce.
+     * Once the nonce range is exhausted the miner moves to the next extra
+     * nonce and refreshes the timestamp, without rebuilding the block.
+     */
+    static constexpr size_t HEADER_SIZE = 88;
+    static constexpr size_t HEADER_INDEX_OFFSET = 0;
+    static constexpr size_t HEADER_TIMESTAMP_OFFSET = 4;
+    static constexpr size_t HEADER_PREVIOUS_HASH_OFFSET = 12;
+    static constexpr size_t HEADER_MERKLE_ROOT_OFFSET = 44;
+    static constexpr size_t HEADER_TARGET_BITS_OFFSET = 76;
+    static constexpr size_t HEADER_NONCE_OFFSET = 80;
+    static constexpr size_t HEADER_EXTRA_NONCE_OFFSET = 84;
+    
+    /**
+     * @brief Compact target used when none is given; about four leading
+     * zero hex digits (one hash in 65536 succeeds)
+     */
+    static constexpr uint32_t DEFAULT_TARGET_BITS = 0x1effffff;
+    
+    using Header = std::array<uint8_t, HEADER_SIZE>;
+    
     /**
      * @brief Constructor for creating a new block
      * @param indexIn Block index in the chain
      * @param dataIn Transactions to include in this block
      * @param previousHashIn Hash of the previous block in the chain
+     * @param targetBitsIn Compact proof-of-work target
      */
-    Block(uint32_t indexIn, const std::vector<Transaction>& dataIn, const std::string& previousHashIn);
+    Block(uint32_t indexIn, const std::vector<Transaction>& dataIn, const Hash256& previousHashIn,
+          uint32_t targetBitsIn = DEFAULT_TARGET_BITS);
     
     /**
      * @brief Default constructor for deserialization
@@ -31,59 +71,233 @@ public:
      * @brief Constructor for database reconstruction
      * @param previousHashIn Hash of the previous block
      * @param timestampIn Block creation timestamp
-     * @param difficultyIn Mining difficulty used
+     * @param difficultyIn Compact proof-of-work target used
      */
-    Block(const std::string& previousHashIn, time_t timestampIn, uint32_t difficultyIn)
-        : m_index(0), m_timestamp(timestampIn), m_previousHash(previousHashIn), m_nonce(0) {}
+    Block(const Hash256& previousHashIn, time_t timestampIn, uint32_t difficultyIn)
+        : m_index(0), m_timestamp(timestampIn), m_previousHash(previousHashIn),
+          m_targetBits(difficultyIn), m_nonce(0), m_extraNonce(0) {}
     
     /**
      * @brief Generate block hash based on contents
-     * @return SHA-256 hash of block contents
+     * @return SHA-256 hash of the serialized header
+     */
+    Hash256 calculateHash() const;
+    
+    /**
+     * @brief Serialize the fixed binary header that calculateHash hashes
+     * @return Header bytes
+     */
+    Header serializeHeader() const;
+    
+    /**
+     * @brief The block without its transactions
+     * @return Header fields, block hash and transaction count
+     */
+    BlockHeader getHeader() const;
+    
+    /**
+     * @brief Header bytes as a string, for batch hashing
+     * @return Serialized header
      */
-    std::string calculateHash() const;
+    std::string hashPreimage() const;
+    
+    /**
+     * @brief Recompute the Merkle root from the transactions in the body
+     *
+     * Interior nodes hash 0x01 || left || right and an unpaired node is
+     * carried up unchanged (see utils::sha256TreeRoot).
+     * @return Merkle root, or the zero hash for a block without transactions
+     */
+    Hash256 calculateMerkleRoot() const;
+    
+    /**
+     * @brief Store the Merkle root of the current transactions in the header
+     *
+     * Call after the body has been assembled with addTransaction.
+     */
+    void updateMerkleRoot();
+    
+    /**
+     * @brief Build an inclusion proof for one transaction
+     * @param txIndex Position of the transaction in the block
+     * @return Sibling hashes from the leaf up to the root
+     * @throws std::out_of_range if txIndex is not a valid position
+     */
+    std::vector<Hash256> getMerkleProof(size_t txIndex) const;
+    
+    /**
+     * @brief Check that a transaction is committed to by a Merkle root
+     * @param txHash Hash of the transaction
+     * @param txIndex Position of the transaction in its block
+     * @param txCount Number of transactions in the block
+     * @param proof Proof returned by getMerkleProof
+     * @param merkleRoot Root from the block header
+     * @return True if the proof links the transaction to the root
+     */
+    static bool verifyMerkleProof(const Hash256& txHash, size_t txIndex, size_t txCount,
+                                  const std::vector<Hash256>& proof, const Hash256& merkleRoot);
     
     /**
      * @brief Mine the block using Proof of Memories consensus
-     * @param difficulty Mining difficulty (number of leading zeros required)
+     *
+     * Searches for a nonce, extra nonce and timestamp whose header hash
+     * meets the block's target. The search continues until a solution is
+     * found or it is cancelled.
      * @param minerAddress Address of the miner
+     * @param threadCount Number of mining threads, 0 for one per hardware thread
+     * @param cancel Optional flag; setting it to true stops mining
+     * @param progress Optional counter of hashes tried, updated while mining
+     * @param telemetry Optional recorder for the search's hash counts and timing
      * @return True if mining was successful, false otherwise
      */
-    bool mineBlock(int difficulty, const std::string& minerAddress);
+    bool mineBlock(const std::string& minerAddress, size_t threadCount = 0,
+                   const std::atomic<bool>* cancel = nullptr,
+                   std::atomic<uint64_t>* progress = nullptr,
+                   MiningTelemetry* telemetry = nullptr);
+    
+    /**
+     * @brief Expand the compact target
+     * @return 256-bit target, or the zero hash if the encoding is invalid
+     */
+    Hash256 getTarget() const;
+    
+    /**
+     * @brief Check whether the stored hash satisfies the block's own target
+     * @return True if the proof of work is sufficient
+     */
+    bool hasValidProofOfWork() const;
     
     // Getters
     uint32_t getIndex() const;
     time_t getTimestamp() const;
-    std::string getPreviousHash() const;
-    std::string getHash() const;
-    std::vector<Transaction> getTransactions() const;
+    Hash256 getPreviousHash() const;
+    Hash256 getHash() const;
+    const std::vector<Transaction>& getTransactions() const;
     uint32_t getNonce() const;
+    uint32_t getExtraNonce() const { return m_extraNonce; }
     std::string getMinerAddress() const;
     
-    // For database operations
+    // For database operations; call updateMerkleRoot once the body is complete
+    // unless the stored root is restored with setMerkleRoot
     void addTransaction(const Transaction& tx) { m_transactions.push_back(tx); }
     
     // Additional methods for database adapter
-    void setHash(const std::string& hash) { m_hash = hash; }
+    void setHash(const Hash256& hash) { m_hash = hash; }
     void setNonce(uint32_t nonce) { m_nonce = nonce; }
+    void setExtraNonce(uint32_t extraNonce) { m_extraNonce = extraNonce; }
     
     // These methods aren't in the current Block implementation
     // but are needed by the database adapter
-    void setMerkleRoot(const std::string& merkleRoot) { /* Not used in current implementation */ }
+    void setMerkleRoot(const Hash256& merkleRoot) { m_merkleRoot = merkleRoot; }
     void setHeight(uint32_t height) { /* Not used in current implementation */ }
-    uint32_t getDifficulty() const { return 0; /* Not tracked in current implementation */ }
-    std::string getMerkleRoot() const { return ""; /* Not implemented */ }
+    uint32_t getDifficulty() const { return m_targetBits; } // Compact target bits
+    uint32_t getTargetBits() const { return m_targetBits; }
+    Hash256 getMerkleRoot() const { return m_merkleRoot; }
     uint32_t getHeight() const { return m_index; /* Using index as height */ }
     
     // For JSON serialization
     std::string toJson() const;
     static Block fromJson(const std::string& json);
     
+    /**
+     * @brief Binary encoding stored in the block log: the header, the
+     * block hash, the miner address and the transactions
+     * @return Encoded block
+     */
+    std::string serialize() const;
+    
+    /**
+     * @brief Decode a block written by serialize
+     * @param data Encoded block
+     * @param length Size of the encoding
+     * @param block Receives the block
+     * @return False if the bytes are truncated or malformed
+     */
+    static bool deserialize(const uint8_t* data, size_t length, Block& block);
+    
 private:
     uint32_t m_index;
     time_t m_timestamp;
     std::vector<Transaction> m_transactions;
-    std::string m_previousHash;
-    std::string m_hash;
+    Hash256 m_previousHash;
+    Hash256 m_merkleRoot;
+    uint32_t m_targetBits;
+    Hash256 m_hash;
     uint32_t m_nonce;
+    uint32_t m_extraNonce;
     std::string m_minerAddress;
+    
+    // Hash every transaction, several at a time where SIMD lanes allow
+    std::vector<Hash256> calculateTransactionHashes() const;
+};
+
+/**
+ * @class BlockHeader
+ * @brief The fixed-size part of a block, without its transactions
+ *
+ * What the chain keeps resident for every block; bodies are loaded on
+ * demand. Getters mirror Block's.
+ */
+class BlockHeader {
+public:
+    BlockHeader()
+        : m_index(0), m_timestamp(0), m_targetBits(0), m_nonce(0), m_extraNonce(0),
+          m_transactionCount(0) {}
+    explicit BlockHeader(const Block& block);
+    
+    /**
+     * @brief Serialize the fixed binary header (see Block::HEADER_SIZE)
+     * @return Header bytes
+     */
+    Block::Header serialize() const;
+    
+    /**
+     * @brief Header bytes as a string, for batch hashing
+     * @return Serialized header
+     */
+    std::string hashPreimage() const;
+    
+    /**
+     * @brief Expand the compact target
+     * @return 256-bit target, or the zero hash if the encoding is invalid
+     */
+    Hash256 getTarget() const;
+    
+    /**
+     * @brief Check whether the stored hash satisfies the header's own target
+     * @return True if the proof of work is sufficient
+     */
+    bool hasValidProofOfWork() const;
+    
+    uint32_t getIndex() const { return m_index; }
+    uint32_t getHeight() const { return m_index; }
+    time_t getTimestamp() const { return m_timestamp; }
+    Hash256 getPreviousHash() const { return m_previousHash; }
+    Hash256 getMerkleRoot() const { return m_merkleRoot; }
+    uint32_t getTargetBits() const { return m_targetBits; }
+    uint32_t getNonce() const { return m_nonce; }
+    uint32_t getExtraNonce() const { return m_extraNonce; }
+    Hash256 getHash() const { return m_hash; }
+    uint32_t getTransactionCount() const { return m_transactionCount; }
+    
+    /**
+     * @brief Decode the header of a block written by Block::serialize,
+     * without decoding its transactions
+     * @param data Encoded block
+     * @param length Size of the encoding
+     * @param header Receives the header
+     * @return False if the bytes are truncated or malformed
+     */
+    static bool deserialize(const uint8_t* data, size_t length, BlockHeader& header);
+    
+private:
+    uint32_t m_index;
+    time_t m_timestamp;
+    Hash256 m_previousHash;
+    Hash256 m_merkleRoot;
+    uint32_t m_targetBits;
+    uint32_t m_nonce;
+    uint32_t m_extraNonce;
+    Hash256 m_hash;
+    uint32_t m_transactionCount;
 };
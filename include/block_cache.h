@@ -0,0 +1,105 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include "block.h"
+
+class BlockStore;
+
+/**
+ * @struct BlockCacheStats
+ * @brief Counters of a BlockCache since it was created
+ */
+struct BlockCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;        // Lookups that went to the block store
+    uint64_t evictions = 0;
+    size_t size = 0;            // Bodies resident now
+    size_t capacity = 0;
+};
+
+/**
+ * @class BlockCache
+ * @brief Bounded LRU cache of block bodies, keyed by height
+ *
+ * Misses are read from the block store. Only bodies the store holds are
+ * ever evicted, so without a store every body stays resident and the
+ * capacity is not enforced.
+ */
+class BlockCache {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024;    // Blocks
+
+    explicit BlockCache(size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Read bodies missing from the cache from this store
+     * @param store Block store holding the chain's bodies
+     */
+    void setSource(std::shared_ptr<const BlockStore> store);
+
+    /**
+     * @brief Look up a body, loading and caching it on a miss
+     * @param height Block height
+     * @return The body, or nullptr if it is neither cached nor readable
+     */
+    std::shared_ptr<const Block> get(size_t height);
+
+    /**
+     * @brief Look up a body for a one-off scan of many blocks
+     *
+     * Uses a cached body if there is one, but neither caches what it loads
+     * nor counts towards the hit rate, so a scan does not flush the cache.
+     * @param height Block height
+     * @return The body, or nullptr if it is neither cached nor readable
+     */
+    std::shared_ptr<const Block> read(size_t height) const;
+
+    /**
+     * @brief Cache the body of a newly appended block
+     * @param block Body; its index is the key
+     */
+    void insert(std::shared_ptr<const Block> block);
+
+    /**
+     * @brief Drop the bodies at height and above
+     * @param height First height to drop
+     */
+    void truncate(size_t height);
+
+    /**
+     * @brief Drop the bodies below height, once the store has pruned them
+     * @param height First height to keep
+     */
+    void prune(size_t height);
+
+    /**
+     * @brief First height whose body the source still holds
+     * @return The source's pruned height, or 0 without a source
+     */
+    size_t getPrunedHeight() const;
+
+    BlockCacheStats getStats() const;
+
+private:
+    using Entry = std::shared_ptr<const Block>;
+
+    // Callers hold m_mutex
+    void insertLocked(const Entry& block);
+    void evictLocked();
+
+    mutable std::mutex m_mutex;
+    size_t m_capacity;
+    std::shared_ptr<const BlockStore> m_source;
+
+    // Most recently used at the front
+    std::list<Entry> m_lru;
+    std::unordered_map<size_t, std::list<Entry>::iterator> m_entries;
+
+    uint64_t m_hits;
+    uint64_t m_misses;
+    uint64_t m_evictions;
+};
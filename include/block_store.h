@@ -0,0 +1,207 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <cstdint>
+#include "block.h"
+#include "binary_io.h"
+#include "hash256.h"
+#include "memory_proof.h"
+
+/**
+ * @class BlockStore
+ * @brief Append-only binary log of the chain's blocks
+ *
+ * Blocks are written in height order to numbered segment files
+ * (blocks-000000.dat, ...) in one directory. Each record is a fixed header
+ * (magic, payload length, CRC-32 of the payload) followed by the block's
+ * binary encoding, so a torn write at the tail is detected on the next
+ * open and cut off. An in-memory index maps heights and block hashes to
+ * record offsets.
+ *
+ * Appends only write(); durability comes from sync(), which lets
+ * concurrent callers share one fdatasync (group commit).
+ *
+ * prune() discards old bodies a whole segment at a time. Before a segment
+ * is deleted, the header part of each of its records (the prefix of the
+ * payload that BlockHeader::deserialize reads) is appended to headers.dat,
+ * so every height keeps its header and Merkle root.
+ *
+ * Memory proofs are not part of any block, so the store keeps them in a
+ * log of their own (memory_proofs.dat), each one flushed as it is added.
+ */
+class BlockStore {
+public:
+    static constexpr uint32_t RECORD_MAGIC = 0x4b424841;            // "AHBK"
+    static constexpr size_t RECORD_HEADER_SIZE = 12;                // Magic, length, CRC
+    static constexpr uint64_t DEFAULT_SEGMENT_SIZE = 64ull << 20;   // Roll over past this
+    static constexpr uint32_t HEADER_RECORD_MAGIC = 0x44484841;     // "AHHD"
+    static constexpr size_t MAX_PRUNE_SEGMENTS = 4;                 // Per prune() call
+    static constexpr uint32_t MEMORY_PROOF_RECORD_MAGIC = 0x504d4841;   // "AHMP"
+
+    /**
+     * @brief Constructor
+     * @param directory Directory holding the segment files; created on open
+     * @param segmentSize Size at which a new segment is started
+     */
+    explicit BlockStore(const std::string& directory, uint64_t segmentSize = DEFAULT_SEGMENT_SIZE);
+    ~BlockStore();
+
+    BlockStore(const BlockStore&) = delete;
+    BlockStore& operator=(const BlockStore&) = delete;
+
+    /**
+     * @brief Index every stored block and open the log for appending
+     *
+     * Segments are read through a read-only memory mapping. Every record's
+     * checksum is verified but only its header is decoded; bodies are read
+     * later with readBlock. A record cut short by the end of the last
+     * segment or of headers.dat (an interrupted write) is truncated away.
+     * Any other damage, including a complete record with a bad checksum,
+     * fails the open rather than discard the blocks after it.
+     * @param headers Receives the stored block headers in height order,
+     * including those of pruned blocks
+     * @return True if the store was opened
+     */
+    bool open(std::vector<BlockHeader>& headers);
+
+    /**
+     * @brief Append the block at the next height
+     * @param block Block whose index equals size()
+     * @param sequence Receives the sequence number to pass to sync()
+     * @return True if the record was written (not necessarily durable)
+     */
+    bool append(const Block& block, uint64_t& sequence);
+
+    /**
+     * @brief Make every append up to sequence durable
+     *
+     * Callers that arrive while a sync is running wait for it and, if it
+     * did not cover them, share the next one.
+     * @param sequence Sequence number returned by append
+     * @return False if the flush failed
+     */
+    bool sync(uint64_t sequence);
+
+    /**
+     * @brief Make every append so far durable
+     * @return False if the flush failed
+     */
+    bool syncAll();
+
+    /**
+     * @brief Drop the blocks at height and above
+     * @param height New number of stored blocks; not below a pruned header
+     * @return True if the log was cut back
+     */
+    bool truncate(size_t height);
+
+    /**
+     * @brief Discard the bodies of old blocks, keeping their headers
+     *
+     * Only segments holding no block at or above height are deleted, and
+     * never the one being appended to, so nothing is rewritten. Each call
+     * deletes at most MAX_PRUNE_SEGMENTS segments, which bounds the I/O of
+     * one call to reading that many segments' headers; later calls catch up.
+     * @param height Bodies below this height may be discarded
+     * @return False if the headers could not be archived; nothing is
+     * deleted then
+     */
+    bool prune(size_t height);
+
+    /**
+     * @brief Durably record memory proofs
+     * @param proofs Proofs to append, in upload order
+     * @param hashes Proof hash of each, in the same order
+     * @return True once the records are flushed; nothing is kept otherwise
+     */
+    bool appendMemoryProofs(const std::vector<MemoryProof>& proofs, const std::vector<Hash256>& hashes);
+
+    /**
+     * @brief Read back every recorded memory proof
+     *
+     * A record cut short by the end of the log is truncated away, like
+     * the tail of the last segment.
+     * @param proofs Receives the proofs in the order they were appended
+     * @param hashes Receives the proof hash of each
+     * @return False if the log is damaged
+     */
+    bool loadMemoryProofs(std::vector<MemoryProof>& proofs, std::vector<Hash256>& hashes);
+
+    /**
+     * @brief Read one stored block
+     * @param height Block height
+     * @param block Receives the block
+     * @return False if the height is not stored, its body was pruned or
+     * the record is damaged
+     */
+    bool readBlock(size_t height, Block& block) const;
+
+    /**
+     * @brief Look up the height of a stored block
+     * @param hash Block hash
+     * @param height Receives the height
+     * @return True if the block is stored
+     */
+    bool findHeight(const Hash256& hash, size_t& height) const;
+
+    size_t size() const;
+
+    // Bodies below this height have been pruned
+    size_t getPrunedHeight() const;
+    const std::string& getDirectory() const { return m_directory; }
+
+private:
+    // Segment of a block whose body was pruned
+    static constexpr uint32_t PRUNED_SEGMENT = UINT32_MAX;
+
+    // Where one block's record lives
+    struct Location {
+        uint32_t segment;
+        uint64_t offset;    // Start of the record header
+        uint32_t length;    // Payload length
+        Hash256 hash;
+    };
+
+    std::string segmentPath(uint32_t segment) const;
+    std::string headersPath() const;
+    std::string memoryProofsPath() const;
+    bool listSegments(std::vector<uint32_t>& segments) const;
+    bool loadHeaders(std::vector<BlockHeader>& headers);
+    bool loadSegment(uint32_t segment, bool last, std::vector<BlockHeader>& headers);
+    bool archiveHeaders(const std::vector<Location>& locations, ahmiyat::utils::BinaryWriter& records) const;
+    bool openAppendSegment(uint32_t segment);
+    void closeAppendSegment();
+    bool syncDirectory() const;
+
+    std::string m_directory;
+    uint64_t m_segmentSize;
+
+    // Guards the index and the append descriptor
+    mutable std::mutex m_mutex;
+    std::vector<Location> m_index;
+    std::unordered_map<Hash256, size_t> m_heightByHash;
+    int m_fd;                   // Open for appending to the last segment
+    uint32_t m_segment;         // Segment m_fd writes to
+    uint64_t m_segmentLength;   // Bytes in that segment
+    uint64_t m_appendSequence;  // Appends so far
+    size_t m_prunedHeight;      // Heights below have no body
+    size_t m_headerCount;       // Records in headers.dat
+
+    // Serializes prune(), which reads segments and writes headers.dat
+    // outside m_mutex; only open and prune change m_headersLength
+    std::mutex m_pruneMutex;
+    uint64_t m_headersLength;   // Bytes in headers.dat
+
+    // Serializes writes to memory_proofs.dat
+    std::mutex m_memoryProofMutex;
+
+    // Group commit; taken before m_mutex when both are needed
+    std::mutex m_syncMutex;
+    std::condition_variable m_syncDone;
+    uint64_t m_syncedSequence;
+    bool m_syncing;
+};
@@ -3,11 +3,65 @@
 #include <vector>
 #include <string>
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <memory>
 #include <unordered_map>
+#include <future>
 #include "block.h"
+#include "block_cache.h"
+#include "chain_snapshot.h"
+#include "mempool.h"
 #include "transaction.h"
 #include "wallet.h"
 #include "memory_proof.h"
+#include "mining_telemetry.h"
+#include "state_snapshot.h"
+#include "thread_pool.h"
+
+class BlockStore;
+
+/**
+ * @struct TransactionPage
+ * @brief One page of an address's confirmed transactions, newest first
+ */
+struct TransactionPage {
+    std::vector<Transaction> transactions;
+    std::vector<TransactionLocation> locations; // Parallel to transactions
+    size_t total = 0;                           // Transactions involving the address
+    size_t nextCursor = 0;                      // Cursor for the next (older) page
+    bool hasMore = false;
+    bool incomplete = false;                    // A block could not be read; nextCursor resumes at it
+};
+
+/**
+ * @struct ChainValidationResult
+ * @brief Outcome of validating the chain
+ */
+struct ChainValidationResult {
+    bool valid = true;
+    size_t invalidHeight = 0;   // Lowest invalid block; set when !valid
+    std::string error;          // Why that block is invalid
+    size_t fromHeight = 0;      // First height checked; above 1 when a checkpoint was used
+    size_t blocksChecked = 0;   // Blocks whose contents were checked
+};
+
+/**
+ * @struct ValidationCheckpoint
+ * @brief Prefix of the chain already known to be valid
+ *
+ * Blocks below height are valid. The checkpoint applies to a chain only if
+ * its block at height - 1 still has tipHash.
+ */
+struct ValidationCheckpoint {
+    size_t height = 0;
+    Hash256 tipHash;
+};
+
+enum class ValidationMode {
+    INCREMENTAL,    // Check only blocks above a matching checkpoint
+    FULL_AUDIT      // Check every block regardless of the checkpoint
+};
 
 /**
  * @class Blockchain
@@ -21,43 +75,207 @@
  */
 class Blockchain {
 public:
+    // Difficulty retargeting: each block's target is the mean target of the
+    // previous RETARGET_WINDOW blocks, scaled by how long they actually took
+    // versus RETARGET_WINDOW * TARGET_BLOCK_INTERVAL
+    static constexpr uint32_t TARGET_BLOCK_INTERVAL = 60;   // Seconds
+    static constexpr size_t RETARGET_WINDOW = 20;           // Blocks
+    static constexpr uint32_t MAX_ADJUSTMENT_FACTOR = 4;    // Per-window clamp
+    static constexpr uint32_t MAX_TARGET_BITS = 0x1fffffff; // Easiest allowed target
+    
+    // Blocks per validation task; large enough to fill the SHA-256 lanes
+    static constexpr size_t VALIDATION_CHUNK_SIZE = 256;
+    
+    // Blocks between state snapshots written in the background while a
+    // block store is attached
+    static constexpr size_t STATE_SNAPSHOT_INTERVAL = 100;
+    
+    // Prune depth that keeps every block body
+    static constexpr size_t NO_PRUNING = 0;
+    
     Blockchain();
+    ~Blockchain();
     
     // Block operations
     bool addBlock(const std::string& minerAddress);
     Block getLatestBlock() const;
+    BlockHeader getLatestHeader() const;
+    
+    // Reads every body not pruned; prefer getChainSnapshot and getBlock
     std::vector<Block> getChain() const;
+    
+    // The chain's headers as of the last append, without copying any;
+    // safe to read from any thread while blocks are being added
+    std::shared_ptr<const ChainSnapshot> getChainSnapshot() const;
+    
+    // Only headers stay resident; bodies come from an LRU cache over the
+    // block store. nullptr if the height is past the tip or unreadable
+    std::shared_ptr<const Block> getBlock(size_t height) const;
+    BlockCacheStats getBlockCacheStats() const;
+    
+    // Pruning: once a state snapshot covering them is on disk, the store
+    // discards the bodies of blocks more than depth below the tip, whole
+    // segments at a time. Headers (with their Merkle roots) are kept for
+    // every height, so the chain still validates as a header chain and
+    // transaction proofs still verify; getBlock returns nullptr below the
+    // pruned height. Set the depth before loadChain or saveChain
+    void setPruneDepth(size_t depth);
+    size_t getPruneDepth() const;
+    size_t getPrunedHeight() const;
+    
+    // Check a Merkle proof (Block::getMerkleProof) of a transaction against
+    // the header of the block at height; needs no body
+    bool verifyTransactionProof(size_t height, const Hash256& txHash, size_t txIndex,
+                                const std::vector<Hash256>& proof) const;
     bool isChainValid() const;
     
+    // Validate the blocks of a snapshot across the shared thread pool and
+    // report the lowest invalid height. Incremental validation starts above
+    // the checkpoint; either mode moves the checkpoint to the valid prefix
+    ChainValidationResult validateChain(ValidationMode mode = ValidationMode::INCREMENTAL) const;
+    
+    // Blocks accepted by submitBlock were validated on the way in and
+    // extend the checkpoint directly. Saving the checkpoint lets a restart
+    // skip re-validating the history it covers
+    ValidationCheckpoint getValidationCheckpoint() const;
+    bool saveValidationCheckpoint(const std::string& filename) const;
+    bool loadValidationCheckpoint(const std::string& filename);
+    uint32_t getNextTargetBits() const;
+    
     // Transaction operations
     bool addTransaction(const Transaction& transaction);
     std::vector<Transaction> getPendingTransactions() const;
     bool processTransaction(const Transaction& transaction);
     double getBalance(const std::string& address) const;
     
+    // Cursor 0 starts at the newest transaction; pass back nextCursor for
+    // older ones. Cursors stay valid as blocks are appended
+    TransactionPage getTransactionsForAddress(const std::string& address, size_t cursor = 0,
+                                              size_t limit = 50) const;
+    
     // Memory proof operations
     bool verifyMemoryProof(const MemoryProof& proof);
     bool storeMemoryProof(const MemoryProof& proof);
     
     // Mining and rewards
     void minePendingTransactions(const std::string& minerAddress);
+    
+    // Template mining: snapshot the next block (pending transactions plus the
+    // mining reward) under the chain lock, mine it without holding the lock,
+    // then submit it; submission fails if the chain moved on meanwhile
+    bool createBlockTemplate(const std::string& minerAddress, Block& block) const;
+    bool mineBlockTemplate(Block& block, const std::string& minerAddress, size_t threadCount = 0,
+                           const std::atomic<bool>* cancel = nullptr,
+                           std::atomic<uint64_t>* progress = nullptr);
+    bool submitBlock(const Block& block);
+    
+    // Hash counts, hash rates and time to solution of every search run
+    // through this chain
+    MiningStats getMiningStats() const;
     double getMiningReward() const;
     void setMiningReward(double reward);
     
     // Utility functions
     size_t getChainSize() const;
     std::string getChainAsJson() const;
-    void saveChain(const std::string& filename) const;
-    bool loadChain(const std::string& filename);
+    
+    // Persistence goes through a binary block store in a directory. Once
+    // attached by either call, every submitted block is appended to it
+    // and flushed before submitBlock returns. saveChain writes the chain
+    // to an empty store (or flushes the attached one); loadChain replaces
+    // a fresh chain with the stored one, re-validating only the blocks
+    // above the saved checkpoint and dropping any invalid suffix.
+    // Derived state (balances, address history, memory proofs) is restored
+    // from the store's state snapshot, replaying only the blocks above it.
+    // Memory proofs are also logged in the store as they are stored, so
+    // those newer than the snapshot survive a crash
+    bool saveChain(const std::string& directory);
+    bool loadChain(const std::string& directory);
     
 private:
-    std::vector<Block> m_chain;
-    std::vector<Transaction> m_pendingTransactions;
+    // Replaced (never modified) on every append, under m_chainMutex; read
+    // with std::atomic_load so readers need not take the mutex
+    std::shared_ptr<const ChainSnapshot> m_chain;
+    
+    // Has its own locks; transactions are added to it under a shared lock
+    // on m_chainMutex, and removed when a block is appended under an
+    // exclusive one
+    Mempool m_mempool;
+    
     std::unordered_map<std::string, std::vector<MemoryProof>> m_memoryProofs;
+    
+    // Hash indexes over m_memoryProofs, so reward validation and duplicate
+    // detection need not scan (or re-hash) every stored proof
+    struct MemoryProofRef {
+        std::string uploader;
+        size_t position; // Index into m_memoryProofs[uploader]
+    };
+    std::unordered_map<Hash256, MemoryProofRef> m_memoryProofsByHash;
+    // Keyed by content key, so one file counts once whatever its hash mode
+    std::unordered_map<Hash256, MemoryProofRef> m_memoryProofsByContentKey;
+    
+    // Balances implied by the chain, kept in step with m_chain so balance
+    // lookups need not scan it; the mempool tracks pending changes
+    std::unordered_map<std::string, double> m_confirmedBalances;
+    
+    // Every confirmed transaction sending from or paying to an address,
+    // in chain order
+    std::unordered_map<std::string, std::vector<TransactionLocation>> m_addressHistory;
+    
     double m_miningReward;
-    mutable std::mutex m_chainMutex;
+    MiningTelemetry m_miningTelemetry;
+    std::atomic<size_t> m_pruneDepth;
+    
+    // Moved by validateChain, which is const, so it has its own mutex;
+    // taken after m_chainMutex when both are needed
+    mutable ValidationCheckpoint m_validationCheckpoint;
+    mutable std::mutex m_checkpointMutex;
+    
+    // Exclusive for appending blocks and storing memory proofs; shared for
+    // everything that only reads, including adding to the mempool
+    mutable std::shared_mutex m_chainMutex;
+    
+    // Set once, under m_chainMutex, by saveChain or loadChain
+    std::shared_ptr<BlockStore> m_blockStore;
+    
+    // Bodies of the blocks in m_chain. Until a store is attached it holds
+    // every body; after that, recently used ones
+    mutable BlockCache m_blockCache;
+    
+    // Writes state snapshots off the submitting thread, one at a time.
+    // m_stateSnapshotMutex is taken before m_chainMutex
+    std::unique_ptr<ahmiyat::utils::ThreadPool> m_stateSnapshotWriter;
+    std::future<bool> m_pendingStateSnapshot;
+    std::mutex m_stateSnapshotMutex;
     
     Block createGenesisBlock();
+    bool buildBlockTemplate(const std::string& minerAddress, bool includeReward, Block& block) const;
     bool hasEnoughMemoriesForMining(const std::string& address) const;
-    bool isValidNewBlock(const Block& newBlock, const Block& previousBlock) const;
+    double calculateBalance(const std::string& address) const;
+    double getConfirmedBalance(const std::string& address) const;
+    void appendBlock(const Block& block);
+    void applyBlockState(const Block& block);
+    bool replaceChain(const std::shared_ptr<BlockStore>& store, std::vector<BlockHeader>& headers,
+                      const StateSnapshot* state);
+    void restoreGenesis(const std::shared_ptr<const Block>& genesis);
+    bool resetChain(const std::vector<BlockHeader>& headers, const StateSnapshot* state = nullptr);
+    void indexMemoryProof(const MemoryProof& proof, const Hash256& proofHash);
+    void restoreMemoryProofs(const StateSnapshot& state);
+    bool writeChain(BlockStore& store) const;
+    void attachBlockStore(std::shared_ptr<BlockStore> store);
+    void captureState(StateSnapshot& state) const;
+    size_t pruneHeight() const;
+    bool pruneBlockBodies(size_t height);
+    void scheduleStateSnapshot();
+    bool saveStateSnapshot();
+    bool isKnownMemory(const Hash256& contentKey) const;
+    const MemoryProof* findMemoryProof(const Hash256& proofHash) const;
+    bool isValidNewBlock(const ChainSnapshot& chain, const Block& newBlock) const;
+    bool checkBlockLink(const BlockHeader& newBlock, const BlockHeader& previousBlock,
+                        std::string& error) const;
+    bool checkBlockContents(const ChainSnapshot& chain, const BlockHeader& header, const Block& body,
+                            const Hash256& hash, std::string& error) const;
+    bool checkBlockHeader(const ChainSnapshot& chain, const BlockHeader& header, const Hash256& hash,
+                          std::string& error) const;
+    uint32_t calculateTargetBits(const ChainSnapshot& chain, size_t height) const;
 };
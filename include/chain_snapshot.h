@@ -0,0 +1,13 @@
+#pragma once
+
+#include "block.h"
+#include "persistent_log.h"
+
+/**
+ * @brief Immutable view of the chain's headers at one height
+ *
+ * A new snapshot is published on every append; holders of an older one
+ * keep reading a consistent chain without locking. Block bodies are not
+ * part of it; Blockchain::getBlock loads them.
+ */
+using ChainSnapshot = PersistentLog<BlockHeader>;
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace ahmiyat {
+namespace utils {
+
+// Closes the descriptor when leaving scope
+struct FileDescriptor {
+    int fd;
+
+    explicit FileDescriptor(const std::string& path, int flags = O_RDONLY | O_CLOEXEC)
+        : fd(::open(path.c_str(), flags, 0644)) {}
+    ~FileDescriptor() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+};
+
+// Read-only mapping of a whole file, unmapped when leaving scope
+struct FileMapping {
+    void* data;
+    size_t size;
+
+    FileMapping(int fd, size_t length, int advice)
+        : data(length > 0 ? ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED),
+          size(length) {
+        if (valid()) {
+            ::madvise(data, size, advice);
+        }
+    }
+    ~FileMapping() {
+        if (valid()) {
+            ::munmap(data, size);
+        }
+    }
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+
+    bool valid() const { return data != MAP_FAILED; }
+    const uint8_t* bytes() const { return static_cast<const uint8_t*>(data); }
+};
+
+// Write all of data, retrying short and interrupted writes
+inline bool writeAll(int fd, const void* data, size_t length) {
+    const char* bytes = static_cast<const char*>(data);
+    size_t written = 0;
+    while (written < length) {
+        ssize_t result = ::write(fd, bytes + written, length - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+// Flush a directory, making entries created or renamed in it durable
+inline bool syncDirectory(const std::string& path) {
+    FileDescriptor directory(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return directory.fd >= 0 && ::fsync(directory.fd) == 0;
+}
+
+} // namespace utils
+} // namespace ahmiyat
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <ostream>
+
+/**
+ * @class Hash256
+ * @brief Fixed-size 32-byte SHA-256 digest
+ *
+ * Used for every block, transaction and memory digest inside the core.
+ * Hex encoding only happens at the JSON/HTTP/database boundary.
+ */
+class Hash256 {
+public:
+    static constexpr size_t SIZE = 32;
+
+    /**
+     * @brief Default constructor, creates the all-zero hash
+     */
+    Hash256() : m_bytes{} {}
+
+    /**
+     * @brief Construct from raw digest bytes
+     * @param bytes 32 bytes of digest data
+     */
+    explicit Hash256(const std::array<uint8_t, SIZE>& bytes) : m_bytes(bytes) {}
+
+    /**
+     * @brief Parse a 64-character hex string
+     * @param hex Hex representation of the hash
+     * @return Parsed hash
+     * @throws std::invalid_argument if the string is not a valid digest
+     */
+    static Hash256 fromHex(const std::string& hex);
+
+    /**
+     * @brief Parse a 64-character hex string without throwing
+     * @param hex Hex representation of the hash
+     * @param out Receives the parsed hash on success
+     * @return True if the string was a valid digest, false otherwise
+     */
+    static bool tryFromHex(const std::string& hex, Hash256& out);
+
+    /**
+     * @brief Encode the hash as lowercase hex
+     * @return 64-character hex string
+     */
+    std::string toHex() const;
+
+    /**
+     * @brief Check whether every byte is zero
+     * @return True for the default (null) hash
+     */
+    bool isZero() const;
+
+    // Raw byte access
+    const uint8_t* data() const { return m_bytes.data(); }
+    uint8_t* data() { return m_bytes.data(); }
+    const std::array<uint8_t, SIZE>& bytes() const { return m_bytes; }
+
+    bool operator==(const Hash256& other) const {
+        return std::memcmp(m_bytes.data(), other.m_bytes.data(), SIZE) == 0;
+    }
+
+    bool operator!=(const Hash256& other) const {
+        return !(*this == other);
+    }
+
+    bool operator<(const Hash256& other) const {
+        return std::memcmp(m_bytes.data(), other.m_bytes.data(), SIZE) < 0;
+    }
+
+    /**
+     * @brief Hash value for unordered containers
+     *
+     * SHA-256 output is already uniformly distributed, so the first
+     * machine word of the digest is used directly.
+     */
+    size_t hashCode() const {
+        size_t value;
+        std::memcpy(&value, m_bytes.data(), sizeof(value));
+        return value;
+    }
+
+private:
+    std::array<uint8_t, SIZE> m_bytes;
+};
+
+std::ostream& operator<<(std::ostream& os, const Hash256& hash);
+
+namespace std {
+template <>
+struct hash<Hash256> {
+    size_t operator()(const Hash256& h) const noexcept {
+        return h.hashCode();
+    }
+};
+} // namespace std
@@ -4,6 +4,8 @@
 #include <vector>
 #include <ctime>
 #include <cstdint>
+#include "hash256.h"
+#include "binary_io.h"
 
 /**
  * @class MemoryProof
@@ -21,27 +23,36 @@ public:
         TEXT
     };
     
+    // How the file content hash was produced
+    enum class ContentHashMode {
+        SHA256,        // Single SHA-256 pass over the whole file
+        CHUNKED_TREE   // Merkle root over 1 MiB chunk hashes, computed in parallel
+    };
+    
     // Constructor for creating memory proof from actual file
     MemoryProof(const std::string& filePath, 
                 MemoryType type, 
                 const std::string& uploader, 
-                const std::string& description);
+                const std::string& description,
+                ContentHashMode hashMode = ContentHashMode::SHA256);
     
     // Default constructor for STL containers
-    MemoryProof() : m_type(MemoryType::TEXT), m_timestamp(0) {}
+    MemoryProof() : m_type(MemoryType::TEXT), m_timestamp(0), m_hashMode(ContentHashMode::SHA256) {}
     
-    // Constructor for reconstructing memory proof from data
-    MemoryProof(const std::string& fileHash,
+    // Constructor for reconstructing memory proof from data; without the
+    // file, the content key is taken to be the file hash
+    MemoryProof(const Hash256& fileHash,
                 MemoryType type,
                 const std::string& uploader,
                 const std::string& description,
                 time_t timestamp,
-                const std::string& signature);
+                const std::string& signature,
+                ContentHashMode hashMode = ContentHashMode::SHA256);
                 
     // Constructor for database reconstruction
     MemoryProof(const std::string& ownerAddress, 
                 const std::string& filePath, 
-                const std::string& fileHash, 
+                const Hash256& fileHash, 
                 uint64_t fileSize, 
                 const std::string& fileType, 
                 uint64_t timestamp);
@@ -52,42 +63,69 @@ public:
     // Verify memory proof signature
     bool isValid() const;
     
+    /**
+     * @brief Check one chunk of the file against the proof
+     *
+     * Only available for CHUNKED_TREE proofs created from a file, which
+     * carry the per-chunk hashes.
+     * @param chunkIndex Index of the TREE_HASH_CHUNK_SIZE chunk
+     * @param data Chunk bytes
+     * @param length Chunk length
+     * @return True if the chunk matches its recorded hash, false otherwise
+     */
+    bool verifyChunk(size_t chunkIndex, const void* data, size_t length) const;
+    
     // Calculate proof difficulty based on content
     uint32_t calculateProofDifficulty() const;
     
     // Getters
-    std::string getFileHash() const;
+    Hash256 getFileHash() const;
     MemoryType getType() const;
     std::string getUploader() const;
     std::string getDescription() const;
     time_t getTimestamp() const;
     std::string getSignature() const;
-    std::string getProofHash() const;
+    Hash256 getProofHash() const;
+    ContentHashMode getContentHashMode() const;
+    
+    /**
+     * @brief Key that identifies the file content whatever the hash mode
+     * @return CHUNKED_TREE root of the file
+     */
+    Hash256 getContentKey() const;
+    const std::vector<Hash256>& getChunkHashes() const;
     
     // For JSON serialization
     std::string toJson() const;
     static MemoryProof fromJson(const std::string& json);
     
+    // Binary encoding used by state snapshots, the proof log and the memory index
+    void serialize(ahmiyat::utils::BinaryWriter& writer) const;
+    static bool deserialize(ahmiyat::utils::BinaryReader& reader, MemoryProof& proof);
+    
     // For database operations
-    void setHash(const std::string& hash) { m_fileHash = hash; }
+    void setHash(const Hash256& hash) { m_fileHash = hash; m_contentKey = hash; }
     
     // Additional getters/setters for database operations
     std::string getOwnerAddress() const { return m_uploader; }
     std::string getFilePath() const { return m_description; } // Using description as file path
     uint64_t getFileSize() const { return 0; } // Not tracked in current implementation
     std::string getFileType() const { return memoryTypeToString(m_type); }
-    std::string getHash() const { return m_fileHash; } // Alias for getFileHash
+    Hash256 getHash() const { return m_fileHash; } // Alias for getFileHash
     
 private:
-    std::string m_fileHash;      // Hash of the uploaded file content
+    Hash256 m_fileHash;          // Hash of the uploaded file content
+    Hash256 m_contentKey;        // CHUNKED_TREE root, for duplicate detection
     MemoryType m_type;           // Type of memory (image, video, etc.)
     std::string m_uploader;      // Address of the uploader
     std::string m_description;   // User description of the memory
     time_t m_timestamp;          // When the memory was uploaded
     std::string m_signature;     // Cryptographic signature by uploader
+    ContentHashMode m_hashMode;  // Algorithm that produced m_fileHash
+    std::vector<Hash256> m_chunkHashes; // Chunk leaf hashes (CHUNKED_TREE only)
     
     // Calculate hash of memory data for signing
-    std::string calculateHash() const;
+    Hash256 calculateHash() const;
     
     // Helper to convert MemoryType to string for internal use
     static MemoryType stringToMemoryType(const std::string& typeStr);
@@ -95,4 +133,6 @@ private:
 public:
     // Make the memory type conversion function public for easier use
     static std::string memoryTypeToString(MemoryType type);
+    static std::string contentHashModeToString(ContentHashMode mode);
+    static ContentHashMode stringToContentHashMode(const std::string& modeStr);
 };
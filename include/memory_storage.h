@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <mutex>
 #include <filesystem>
+#include "hash256.h"
 #include "memory_proof.h"
 
 namespace fs = std::filesystem;
@@ -13,7 +14,11 @@ namespace fs = std::filesystem;
  * @class MemoryStorage
  * @brief Manages storage of uploaded memory files
  * 
- * Handles file I/O for uploaded memories and their metadata
+ * Handles file I/O for uploaded memories and their metadata. Proofs are
+ * keyed by their file hash, which depends on the hash mode, and also indexed
+ * by the content key each proof carries, so duplicates are detected
+ * whatever mode they were uploaded with. The index, chunk
+ * hashes included, is kept in memory_index.dat.
  */
 class MemoryStorage {
 public:
@@ -30,13 +35,15 @@ public:
      * @param uploader Address of the uploader
      * @param description User description of the memory
      * @param privateKey Private key of the uploader for signing
+     * @param hashMode How to hash the file content
      * @return Memory proof for the stored file
      */
     MemoryProof storeMemory(const std::string& filePath, 
                           MemoryProof::MemoryType type, 
                           const std::string& uploader, 
                           const std::string& description,
-                          const std::string& privateKey);
+                          const std::string& privateKey,
+                          MemoryProof::ContentHashMode hashMode = MemoryProof::ContentHashMode::SHA256);
                           
     /**
      * @brief Store an existing memory proof
@@ -51,7 +58,7 @@ public:
      * @param fileHash Hash of the file to retrieve
      * @return Path to the stored file
      */
-    std::string retrieveMemory(const std::string& fileHash) const;
+    std::string retrieveMemory(const Hash256& fileHash) const;
     
     /**
      * @brief Get all memories uploaded by a specific address
@@ -72,7 +79,22 @@ public:
      * @param fileHash Hash of the file to check
      * @return True if the memory exists, false otherwise
      */
-    bool memoryExists(const std::string& fileHash) const;
+    bool memoryExists(const Hash256& fileHash) const;
+    
+    /**
+     * @brief Check whether a proof's content is stored under any hash mode
+     * @param proof Proof created from the file
+     * @return True if the same content is already stored, false otherwise
+     */
+    bool memoryExists(const MemoryProof& proof) const;
+    
+    /**
+     * @brief Verify one chunk of a stored memory without rehashing the whole file
+     * @param fileHash Hash of the memory (a CHUNKED_TREE root)
+     * @param chunkIndex Index of the 1 MiB chunk to check
+     * @return True if the stored chunk matches the proof, false otherwise
+     */
+    bool verifyMemoryChunk(const Hash256& fileHash, size_t chunkIndex) const;
     
     /**
      * @brief Get list of all addresses that have uploaded memories
@@ -93,10 +115,15 @@ public:
     bool loadIndex();
     
 private:
+    static constexpr uint32_t INDEX_MAGIC = 0x494d4841;   // "AHMI"
+    static constexpr uint32_t INDEX_VERSION = 2;          // 2: proofs carry their content key
+    static constexpr size_t INDEX_HEADER_SIZE = 20;       // Magic, version, payload length, payload CRC
+    
     std::string m_baseDir;
-    std::unordered_map<std::string, MemoryProof> m_memoryIndex;
-    std::unordered_map<std::string, std::vector<std::string>> m_addressToMemories;
-    std::mutex m_storageMutex;
+    std::unordered_map<Hash256, MemoryProof> m_memoryIndex;
+    std::unordered_map<std::string, std::vector<Hash256>> m_addressToMemories;
+    std::unordered_map<Hash256, Hash256> m_filesByContentKey;  // Content key -> file hash
+    mutable std::mutex m_storageMutex;  // Guards the maps; handlers run concurrently
     
     /**
      * @brief Create storage directories
@@ -108,12 +135,17 @@ private:
      * @param filePath Path to the file
      * @return SHA-256 hash of the file
      */
-    std::string calculateFileHash(const std::string& filePath) const;
+    Hash256 calculateFileHash(const std::string& filePath) const;
+    
+    bool isKnownMemory(const MemoryProof& proof) const;
+    void addToIndex(const std::string& uploader, const MemoryProof& proof);
+    void removeFromIndex(const std::string& uploader, const Hash256& fileHash);
+    std::string getIndexPath() const;
     
     /**
      * @brief Generate storage path for a file
      * @param fileHash Hash of the file
      * @return Path where the file should be stored
      */
-    std::string getStoragePath(const std::string& fileHash) const;
+    std::string getStoragePath(const Hash256& fileHash) const;
 };
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include "hash256.h"
+#include "transaction.h"
+#include "persistent_log.h"
+
+enum class MempoolAddResult {
+    ADDED,
+    DUPLICATE,              // Same transaction hash already pending
+    INSUFFICIENT_BALANCE    // Sender cannot cover it on top of its pending spends
+};
+
+/**
+ * @class Mempool
+ * @brief Pending transactions, safe to add to from many threads at once
+ *
+ * Transactions are deduplicated by hash in shards keyed by the hash, and
+ * each sender's pending spends are reserved in shards keyed by address, so
+ * clients sending from different addresses rarely contend. Arrival order is
+ * kept in a PersistentLog that is published atomically, which makes taking
+ * a snapshot for a block template O(1).
+ *
+ * Signed transfers count towards a bound; once it is exceeded the oldest
+ * transfers are evicted in a batch. System transactions (mining and memory
+ * rewards) are never evicted. A transfer may spend only the sender's
+ * confirmed balance, never a pending credit, so evicting any transfer
+ * leaves every other pending spend covered.
+ */
+class Mempool {
+public:
+    using Snapshot = PersistentLog<Transaction>;
+
+    static constexpr size_t SHARD_COUNT = 16;
+
+    /**
+     * @brief Pending transfers kept before the oldest are evicted
+     */
+    static constexpr size_t DEFAULT_MAX_TRANSFERS = 50000;
+
+    /**
+     * @brief Eviction removes at least this fraction (1/n) of the bound at
+     * once, so the log is compacted rarely rather than on every addition
+     */
+    static constexpr size_t EVICTION_BATCH_DIVISOR = 16;
+
+    explicit Mempool(size_t maxTransfers = DEFAULT_MAX_TRANSFERS);
+
+    Mempool(const Mempool&) = delete;
+    Mempool& operator=(const Mempool&) = delete;
+
+    /**
+     * @brief Add a client transaction
+     *
+     * A signed transfer is accepted only if confirmedSenderBalance minus the
+     * sender's pending spends covers it; the amount is reserved in the same
+     * step, so concurrent spends from one sender cannot overdraw. Pending
+     * credits do not count until a block confirms them.
+     * @param transaction Transaction to add
+     * @param confirmedSenderBalance Sender's balance on the chain; must not
+     *        change while the call runs
+     */
+    MempoolAddResult add(const Transaction& transaction, double confirmedSenderBalance);
+
+    /**
+     * @brief Add a system-generated transaction, without dedup or balance checks
+     */
+    void addSystem(const Transaction& transaction);
+
+    /**
+     * @brief Drop transactions a block included, one pending copy per entry
+     * @param transactions Transactions of the block
+     */
+    void remove(const std::vector<Transaction>& transactions);
+
+    /**
+     * @brief Pending transactions in arrival order, without copying them
+     */
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    /**
+     * @brief Net effect of the pending transactions on an address's balance
+     */
+    double getPendingDelta(const std::string& address) const;
+
+    size_t size() const;
+
+    /**
+     * @brief Transfers evicted to keep the pool within its bound
+     */
+    uint64_t getEvictedCount() const;
+
+private:
+    struct TransactionShard {
+        std::mutex mutex;
+        std::unordered_map<Hash256, uint32_t> counts; // Pending copies per hash
+    };
+
+    // The pending count lets an account be dropped once nothing pending
+    // touches it, which also discards accumulated rounding
+    struct Account {
+        double delta = 0.0;
+        double debits = 0.0;    // Pending transfers out; what add() checks
+        uint32_t pending = 0;
+    };
+
+    struct AccountShard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Account> accounts;
+    };
+
+    std::array<TransactionShard, SHARD_COUNT> m_transactionShards;
+    std::array<AccountShard, SHARD_COUNT> m_accountShards;
+
+    // Appends and compactions are serialized by m_logMutex; m_log itself is
+    // read with std::atomic_load so snapshots need no lock
+    std::mutex m_logMutex;
+    std::shared_ptr<const Snapshot> m_log;
+
+    size_t m_maxTransfers;
+    std::atomic<size_t> m_transferCount;
+    std::atomic<uint64_t> m_evictedCount;
+
+    static bool isTransfer(const Transaction& transaction);
+
+    TransactionShard& transactionShard(const Hash256& hash);
+    AccountShard& accountShard(const std::string& address);
+    const AccountShard& accountShard(const std::string& address) const;
+
+    bool claimHash(const Hash256& hash, bool unique);
+    void releaseHash(const Hash256& hash);
+    void applyDelta(const std::string& address, double change);
+    void undoDelta(const std::string& address, double change, double debit = 0.0);
+    void append(const Transaction& transaction);
+    void evict();
+    void release(const std::vector<Transaction>& removed);
+};
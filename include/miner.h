@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+#include <vector>
+#include "hash256.h"
+
+class Block;
+
+/**
+ * @struct MiningResult
+ * @brief Outcome of a nonce search
+ */
+struct MiningResult {
+    bool found = false;         // A nonce meeting the target was found
+    bool cancelled = false;     // The search was stopped through the cancel flag
+    uint32_t nonce = 0;         // Winning nonce (valid when found)
+    uint32_t extraNonce = 0;    // Extra nonce of the winning header (valid when found)
+    time_t timestamp = 0;       // Timestamp of the winning header (valid when found)
+    Hash256 hash;               // Block hash for the winning nonce (valid when found)
+    uint64_t hashesTried = 0;   // Hashes computed across all workers
+    std::vector<uint64_t> threadHashes; // Hashes computed by each worker
+    double seconds = 0.0;       // Wall time of the search
+};
+
+/**
+ * @class Miner
+ * @brief Parallel proof-of-work nonce search
+ *
+ * Each worker owns a disjoint set of extra nonces. For each one it sweeps
+ * the full 32-bit nonce range, then moves to its next extra nonce and
+ * rolls the timestamp forward to the current time, so the search never
+ * runs out of work and never needs a new block template. Workers stop
+ * once any of them finds a solution or the caller raises the cancel flag.
+ */
+class Miner {
+public:
+    /**
+     * @brief Create a miner
+     * @param threadCount Number of worker threads, 0 for one per hardware thread
+     */
+    explicit Miner(size_t threadCount = 0);
+
+    /**
+     * @brief Search for a header that gives the block a hash meeting its target
+     *
+     * The block itself is not modified; the result carries the nonce, extra
+     * nonce and timestamp to apply. The block's own nonce and extra nonce
+     * are ignored.
+     * @param block Block to mine
+     * @param cancel Optional flag; setting it to true stops all workers
+     * @param progress Optional counter the workers add their hash counts to
+     *        while the search runs, for reporting from another thread
+     * @return Search outcome, including the winning nonce and hash
+     */
+    MiningResult mine(const Block& block, const std::atomic<bool>* cancel = nullptr,
+                      std::atomic<uint64_t>* progress = nullptr) const;
+
+    /**
+     * @brief Number of worker threads used per search
+     */
+    size_t getThreadCount() const { return m_threadCount; }
+
+private:
+    size_t m_threadCount;
+};
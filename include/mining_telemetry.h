@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include "hash256.h"
+#include "miner.h"
+
+/**
+ * @struct MiningStats
+ * @brief Snapshot of mining counters accumulated across searches
+ */
+struct MiningStats {
+    /**
+     * @brief Upper bounds, in seconds, of the time-to-solution histogram
+     * buckets; a final bucket collects everything slower
+     */
+    static constexpr std::array<double, 7> SOLVE_TIME_BOUNDS = {0.01, 0.1, 1.0, 10.0, 60.0, 600.0, 3600.0};
+
+    uint64_t blocksFound = 0;
+    uint64_t searchesCancelled = 0;
+    uint64_t searchesFailed = 0;
+
+    uint64_t totalHashes = 0;       // Across every search, successful or not
+    double totalSeconds = 0.0;      // Wall time spent searching
+    double averageHashRate = 0.0;   // totalHashes / totalSeconds
+
+    // Most recent search
+    double lastHashRate = 0.0;
+    std::vector<double> lastThreadHashRates;
+
+    // Time to solution over successful searches
+    double minSolveSeconds = 0.0;
+    double maxSolveSeconds = 0.0;
+    double meanSolveSeconds = 0.0;
+    std::array<uint64_t, SOLVE_TIME_BOUNDS.size() + 1> solveTimeHistogram{};
+
+    // Observed work per block against what the targets predict; a ratio
+    // far from one points at a difficulty or hashing problem
+    double meanHashesPerBlock = 0.0;
+    double meanExpectedHashesPerBlock = 0.0;
+};
+
+/**
+ * @class MiningTelemetry
+ * @brief Thread-safe accumulator for Miner results
+ */
+class MiningTelemetry {
+public:
+    /**
+     * @brief Add one search to the counters
+     * @param result Outcome returned by Miner::mine
+     * @param target Target the search was run against
+     */
+    void record(const MiningResult& result, const Hash256& target);
+
+    /**
+     * @brief Copy the current counters
+     */
+    MiningStats getStats() const;
+
+    /**
+     * @brief Expected number of hashes to find a hash at or below a target
+     * @param target 256-bit target
+     * @return 2^256 / (target + 1), approximately
+     */
+    static double expectedHashes(const Hash256& target);
+
+private:
+    mutable std::mutex m_mutex;
+    MiningStats m_stats;
+    double m_solveSecondsTotal = 0.0;
+    double m_solvedHashesTotal = 0.0;
+    double m_expectedHashesTotal = 0.0;
+};
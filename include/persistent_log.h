@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+/**
+ * @class PersistentLog
+ * @brief Immutable, append-only sequence whose versions share storage
+ *
+ * Items live in fixed-capacity segments that never reallocate, so an item
+ * stays at the same address for as long as any version references it.
+ * Appending produces a new version that shares every existing segment with
+ * the old one; only the small segment table is copied, and only when a new
+ * segment starts. Holding a version is therefore cheap, and reading one
+ * needs no lock: items below its size are never modified again.
+ *
+ * Appends must be serialized by the caller. Readers may use any version
+ * from any thread while an append is in progress.
+ */
+template <typename T>
+class PersistentLog {
+public:
+    /**
+     * @brief Items per storage segment
+     */
+    static constexpr size_t SEGMENT_SIZE = 1024;
+
+    /**
+     * @brief Empty log
+     */
+    PersistentLog() : m_segments(std::make_shared<const SegmentTable>()), m_size(0) {}
+
+    /**
+     * @brief Log holding a copy of items, in order
+     */
+    explicit PersistentLog(const std::vector<T>& items) : m_size(items.size()) {
+        auto segments = std::make_shared<SegmentTable>();
+        for (size_t start = 0; start < items.size(); start += SEGMENT_SIZE) {
+            auto segment = std::make_shared<Segment>();
+            segment->reserve(SEGMENT_SIZE);
+            size_t end = start + SEGMENT_SIZE < items.size() ? start + SEGMENT_SIZE : items.size();
+            segment->assign(items.begin() + start, items.begin() + end);
+            segments->push_back(std::move(segment));
+        }
+        m_segments = std::move(segments);
+    }
+
+    /**
+     * @brief Version with one more item, sharing storage with this one
+     * @param item Item to place at position size()
+     * @return New version; this one is unchanged
+     */
+    std::shared_ptr<const PersistentLog> append(const T& item) const {
+        size_t offset = m_size % SEGMENT_SIZE;
+
+        if (offset != 0) {
+            Segment& tail = *m_segments->back();
+            if (tail.size() == offset) {
+                // The common case: extend the shared tail segment in place.
+                // Readers of older versions never look past their own size
+                tail.push_back(item);
+                return std::shared_ptr<const PersistentLog>(new PersistentLog(m_segments, m_size + 1));
+            }
+        }
+
+        // Either a new segment starts here, or this version is not the newest
+        // and the tail slot is taken; copy the table (and the partial tail) so
+        // no other version sees the change
+        auto segments = std::make_shared<SegmentTable>(*m_segments);
+        auto segment = std::make_shared<Segment>();
+        segment->reserve(SEGMENT_SIZE);
+        if (offset != 0) {
+            const Segment& tail = *segments->back();
+            segment->assign(tail.begin(), tail.begin() + offset);
+            segments->back() = segment;
+        } else {
+            segments->push_back(segment);
+        }
+        segment->push_back(item);
+
+        return std::shared_ptr<const PersistentLog>(new PersistentLog(std::move(segments), m_size + 1));
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    /**
+     * @brief Item at a position
+     * @param position Position below size()
+     */
+    const T& operator[](size_t position) const {
+        return (*(*m_segments)[position / SEGMENT_SIZE])[position % SEGMENT_SIZE];
+    }
+
+    /**
+     * @brief Last item; the log must not be empty
+     */
+    const T& back() const { return (*this)[m_size - 1]; }
+
+    /**
+     * @brief Copy the items into a vector
+     */
+    std::vector<T> toVector() const {
+        std::vector<T> items;
+        items.reserve(m_size);
+        for (size_t i = 0; i < m_size; ++i) {
+            items.push_back((*this)[i]);
+        }
+        return items;
+    }
+
+private:
+    // Each segment is reserved to SEGMENT_SIZE up front; push_back within
+    // the reservation never moves the items already in it
+    using Segment = std::vector<T>;
+    using SegmentTable = std::vector<std::shared_ptr<Segment>>;
+
+    std::shared_ptr<const SegmentTable> m_segments;
+    size_t m_size;
+
+    PersistentLog(std::shared_ptr<const SegmentTable> segments, size_t size)
+        : m_segments(std::move(segments)), m_size(size) {}
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "hash256.h"
+
+namespace ahmiyat {
+namespace utils {
+
+/**
+ * @class Sha256
+ * @brief Incremental SHA-256 context
+ *
+ * Data is fed through any number of update() calls and only the current
+ * partial 64-byte block is buffered, so callers can hash fields in place
+ * instead of concatenating them into a temporary string first.
+ */
+class Sha256 {
+public:
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    Sha256();
+
+    /**
+     * @brief Reset the context to the SHA-256 initial state
+     */
+    void init();
+
+    /**
+     * @brief Feed raw bytes into the hash
+     * @param data Pointer to the bytes
+     * @param length Number of bytes
+     */
+    void update(const void* data, size_t length);
+
+    void update(const std::string& data) { update(data.data(), data.size()); }
+    void update(const Hash256& hash) { update(hash.data(), Hash256::SIZE); }
+
+    /**
+     * @brief Feed an integer as fixed-width little-endian bytes
+     * @param value Value to hash
+     */
+    void updateUint32(uint32_t value);
+    void updateUint64(uint64_t value);
+
+    /**
+     * @brief Feed a string prefixed with its 32-bit length
+     *
+     * Keeps adjacent variable-length fields unambiguous.
+     * @param data String to hash
+     */
+    void updateString(const std::string& data);
+
+    /**
+     * @brief Apply padding and produce the digest
+     *
+     * The context must be re-initialised with init() before reuse.
+     * @return Binary digest
+     */
+    Hash256 final();
+
+private:
+    uint32_t m_state[8];
+    uint8_t m_buffer[BLOCK_SIZE];
+    size_t m_bufferLength;
+    uint64_t m_totalLength;
+};
+
+/**
+ * @class HashPreimage
+ * @brief Records bytes with the same encoding as Sha256's update methods
+ *
+ * Lets a caller build a message once and hand it to sha256Batch, while
+ * producing exactly the digest the equivalent Sha256 calls would.
+ */
+class HashPreimage {
+public:
+    void update(const void* data, size_t length) {
+        m_bytes.append(static_cast<const char*>(data), length);
+    }
+    void update(const std::string& data) { m_bytes.append(data); }
+    void update(const Hash256& hash) { update(hash.data(), Hash256::SIZE); }
+    void updateUint32(uint32_t value);
+    void updateUint64(uint64_t value);
+    void updateString(const std::string& data);
+
+    void reserve(size_t length) { m_bytes.reserve(length); }
+    const std::string& bytes() const { return m_bytes; }
+    std::string& bytes() { return m_bytes; }
+
+private:
+    std::string m_bytes;
+};
+
+/**
+ * @brief Hash many independent messages in parallel SIMD lanes
+ *
+ * Messages are processed 16 at a time with AVX-512 or 8 at a time with
+ * AVX2; other CPUs hash them one by one with the active backend.
+ * @param messages Pointers to each message
+ * @param lengths Length of each message in bytes
+ * @param digests Receives one digest per message
+ * @param count Number of messages
+ */
+void sha256Batch(const uint8_t* const* messages, const size_t* lengths, Hash256* digests, size_t count);
+
+/**
+ * @brief Hash many independent strings in parallel SIMD lanes
+ * @param messages Messages to hash
+ * @return One digest per message, in order
+ */
+std::vector<Hash256> sha256Batch(const std::vector<std::string>& messages);
+
+/**
+ * @class Sha256Midstate
+ * @brief Hash state after a fixed prefix of whole 64-byte blocks
+ *
+ * Messages that share the prefix, such as block headers differing only in
+ * their nonce, are finished from this state without recompressing it.
+ */
+class Sha256Midstate {
+public:
+    /**
+     * @brief Compress the shared prefix
+     * @param prefix Prefix bytes
+     * @param length Prefix length, a multiple of Sha256::BLOCK_SIZE
+     * @throws std::invalid_argument if length is not a whole number of blocks
+     */
+    Sha256Midstate(const void* prefix, size_t length);
+
+    /**
+     * @brief Digest of prefix || tail
+     * @param tail Bytes following the prefix
+     * @param length Tail length
+     * @return Binary digest
+     */
+    Hash256 finish(const void* tail, size_t length) const;
+
+    /**
+     * @brief Digests of prefix || tails[i], computed in parallel SIMD lanes
+     * @param tails Pointers to each tail
+     * @param lengths Length of each tail
+     * @param digests Receives one digest per tail
+     * @param count Number of tails
+     */
+    void finishBatch(const uint8_t* const* tails, const size_t* lengths, Hash256* digests, size_t count) const;
+
+private:
+    uint32_t m_state[8];
+    uint64_t m_prefixLength;
+};
+
+/**
+ * @brief Number of messages sha256Batch hashes side by side
+ * @return 16, 8, or 1 when no multi-buffer kernel is available
+ */
+size_t sha256BatchLanes();
+
+/**
+ * @brief Override the automatically selected batch lane width
+ * @param lanes 16 (AVX-512), 8 (AVX2) or 1 (one message at a time)
+ * @return True if the width is supported and was selected, false otherwise
+ */
+bool sha256SetBatchLanes(size_t lanes);
+
+/**
+ * @brief Compression function implementations
+ *
+ * The fastest backend supported by the CPU is chosen on first use via
+ * CPUID. SCALAR is the portable reference implementation.
+ */
+enum class Sha256Backend {
+    SCALAR,
+    SHA_NI
+};
+
+/**
+ * @brief Run the SHA-256 compression function over whole 64-byte blocks
+ * @param state Eight-word chaining state, updated in place
+ * @param blocks Pointer to blockCount * 64 bytes of message data
+ * @param blockCount Number of blocks to process
+ */
+void sha256Compress(uint32_t state[8], const uint8_t* blocks, size_t blockCount);
+
+// Individual kernels (same contract as sha256Compress); the SHA-NI variant
+// must only be called when sha256BackendSupported() says so
+void sha256CompressScalar(uint32_t state[8], const uint8_t* blocks, size_t blockCount);
+void sha256CompressShaNi(uint32_t state[8], const uint8_t* blocks, size_t blockCount);
+
+/**
+ * @brief Check whether the CPU can run a backend
+ * @param backend Backend to check
+ * @return True if the backend is usable on this machine
+ */
+bool sha256BackendSupported(Sha256Backend backend);
+
+/**
+ * @brief Get the backend currently used by sha256Compress
+ * @return Active backend
+ */
+Sha256Backend sha256GetBackend();
+
+/**
+ * @brief Override the automatically selected backend
+ * @param backend Backend to use from now on
+ * @return True if the backend is supported and was selected, false otherwise
+ */
+bool sha256SetBackend(Sha256Backend backend);
+
+/**
+ * @brief Human-readable backend name
+ * @param backend Backend
+ * @return Name such as "sha-ni"
+ */
+const char* sha256BackendName(Sha256Backend backend);
+
+} // namespace utils
+} // namespace ahmiyat
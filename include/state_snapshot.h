@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "hash256.h"
+#include "memory_proof.h"
+
+/**
+ * @struct TransactionLocation
+ * @brief Position of a transaction in the chain
+ */
+struct TransactionLocation {
+    uint32_t blockIndex;
+    uint32_t txOffset;
+};
+
+/**
+ * @struct StateSnapshot
+ * @brief State derived from the first height blocks of the chain
+ *
+ * Restoring a snapshot whose tip matches the stored chain means only the
+ * blocks above it have to be replayed at startup. Memory proofs are not
+ * recorded in blocks; the snapshot carries those it has seen, and the
+ * block store's proof log adds any stored since.
+ */
+struct StateSnapshot {
+    static constexpr uint32_t MAGIC = 0x54534841;   // "AHST"
+    static constexpr uint32_t VERSION = 2;   // 2: memory proofs carry their content key
+
+    uint64_t height = 0;    // Blocks the state covers
+    Hash256 tipHash;        // Hash of the block at height - 1
+
+    std::unordered_map<std::string, double> balances;
+    std::unordered_map<std::string, std::vector<TransactionLocation>> addressHistory;
+
+    // Each uploader's proofs in upload order, with their proof hashes
+    // alongside so the indexes can be rebuilt without re-hashing
+    std::unordered_map<std::string, std::vector<MemoryProof>> memoryProofs;
+    std::unordered_map<std::string, std::vector<Hash256>> memoryProofHashes;
+
+    /**
+     * @brief Write the snapshot durably, replacing any previous one
+     *
+     * The file is written and flushed beside the old one, then renamed
+     * over it, so a crash leaves one complete snapshot or the other.
+     * @param filename Snapshot file
+     * @return True if the snapshot was written
+     */
+    bool save(const std::string& filename) const;
+
+    /**
+     * @brief Read a snapshot written by save
+     * @param filename Snapshot file
+     * @param snapshot Receives the snapshot
+     * @return False if the file is missing, damaged or from another version
+     */
+    static bool load(const std::string& filename, StateSnapshot& snapshot);
+};
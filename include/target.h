@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "hash256.h"
+
+namespace ahmiyat {
+namespace utils {
+
+/**
+ * Proof-of-work targets are 256-bit big-endian numbers; a block hash meets
+ * its target when, read as a big-endian number, it is not greater than it.
+ *
+ * Blocks store targets in a 32-bit compact form: the top byte is the
+ * number of significant bytes in the target and the low three bytes are
+ * its most significant bytes (the mantissa). Unlike Bitcoin's nBits the
+ * mantissa is unsigned.
+ */
+
+/**
+ * @brief Expand compact target bits into a full 256-bit target
+ * @param bits Compact target
+ * @param target Receives the expanded target on success
+ * @return False if the encoding is zero or does not fit in 256 bits
+ */
+bool compactToTarget(uint32_t bits, Hash256& target);
+
+/**
+ * @brief Encode a target in compact form
+ *
+ * Bits below the three most significant bytes are truncated, so the
+ * encoded target is never easier than the original.
+ * @param target 256-bit target
+ * @return Compact target bits
+ */
+uint32_t targetToCompact(const Hash256& target);
+
+/**
+ * @brief Check a hash against a target
+ * @param hash Block hash
+ * @param target Expanded target
+ * @return True if hash <= target
+ */
+inline bool hashMeetsTarget(const Hash256& hash, const Hash256& target) {
+    return !(target < hash);
+}
+
+/**
+ * @brief Multiply a target by numerator / denominator
+ *
+ * Used for retargeting: a window that took longer than expected scales
+ * the target up (easier), a faster one scales it down.
+ * @param target 256-bit target
+ * @param numerator Scale numerator
+ * @param denominator Scale denominator, must be non-zero
+ * @return Scaled target, saturated to all ones on overflow
+ */
+Hash256 scaleTarget(const Hash256& target, uint32_t numerator, uint32_t denominator);
+
+/**
+ * @brief Arithmetic mean of several targets
+ * @param targets Targets to average
+ * @return Mean target, or the zero hash if targets is empty
+ */
+Hash256 averageTargets(const std::vector<Hash256>& targets);
+
+} // namespace utils
+} // namespace ahmiyat
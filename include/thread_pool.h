@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <cstddef>
+
+namespace ahmiyat {
+namespace utils {
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads consuming a shared task queue
+ *
+ * Used for CPU-bound work that splits into independent pieces, such as
+ * hashing the chunks of a large file.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Start the worker threads
+     * @param threadCount Number of workers, 0 for one per hardware thread
+     */
+    explicit ThreadPool(size_t threadCount = 0);
+
+    /**
+     * @brief Finish queued tasks and join the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queue a task for execution on a worker
+     * @param task Callable taking no arguments
+     * @return Future for the task's result; rethrows anything the task threw
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<typename std::invoke_result<F>::type>;
+
+    /**
+     * @brief Run body(i) for every i in [0, count) and wait for completion
+     *
+     * The calling thread works through indexes too, so this is safe to call
+     * from inside a pool task. The first exception thrown by body is
+     * rethrown once every started call has finished.
+     * @param count Number of indexes
+     * @param body Function called once per index
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    /**
+     * @brief Number of worker threads
+     */
+    size_t size() const { return m_workers.size(); }
+
+    /**
+     * @brief Process-wide pool with one worker per hardware thread
+     */
+    static ThreadPool& shared();
+
+private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping;
+
+    void workerLoop();
+};
+
+template <typename F>
+auto ThreadPool::submit(F&& task) -> std::future<typename std::invoke_result<F>::type> {
+    using Result = typename std::invoke_result<F>::type;
+
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+    std::future<Result> future = packaged->get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.emplace([packaged]() { (*packaged)(); });
+    }
+    m_condition.notify_one();
+
+    return future;
+}
+
+} // namespace utils
+} // namespace ahmiyat
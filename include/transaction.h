@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 #include <ctime>
+#include "hash256.h"
+#include "binary_io.h"
 
 /**
  * @class Transaction
@@ -70,7 +72,7 @@ public:
     // Setters for database operations
     void setSignature(const std::string& signature) { m_signature = signature; }
     void setHash(const std::string& hash) { /* Set internal hash if needed */ }
-    std::string getHash() const { return calculateHash(); }
+    Hash256 getHash() const { return calculateHash(); }
     
     /**
      * @brief Convert transaction to JSON
@@ -85,11 +87,31 @@ public:
      */
     static Transaction fromJson(const std::string& json);
     
+    /**
+     * @brief Append the binary encoding stored in the block log
+     * @param writer Destination
+     */
+    void serialize(ahmiyat::utils::BinaryWriter& writer) const;
+    
+    /**
+     * @brief Decode a transaction written by serialize
+     * @param reader Source, positioned at the transaction
+     * @param transaction Receives the transaction
+     * @return False if the bytes are truncated or malformed
+     */
+    static bool deserialize(ahmiyat::utils::BinaryReader& reader, Transaction& transaction);
+    
     /**
      * @brief Create hash of transaction data for signing
      * @return SHA-256 hash of transaction data
      */
-    std::string calculateHash() const;
+    Hash256 calculateHash() const;
+    
+    /**
+     * @brief Exact bytes hashed by calculateHash, for batch hashing
+     * @return Serialized transaction fields
+     */
+    std::string hashPreimage() const;
     
 private:
     std::string m_fromAddress; // Can be empty for memory reward transactions
@@ -99,4 +121,8 @@ private:
     std::string m_signature;
     TransactionType m_type;
     std::string m_memoryProofHash; // Only for memory reward transactions
+    
+    // Feed the hashed fields into a Sha256 context or a HashPreimage
+    template <typename Sink>
+    void writeHashFields(Sink& sink) const;
 };
@@ -3,8 +3,10 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 #include <ctime>
 #include <utility>  // For std::pair
+#include "hash256.h"
 
 namespace ahmiyat {
 namespace utils {
@@ -16,6 +18,13 @@ namespace utils {
  */
 std::string sha256(const std::string& str);
 
+/**
+ * @brief Calculate SHA-256 digest of a string
+ * @param str String to hash
+ * @return Binary digest
+ */
+Hash256 sha256Digest(const std::string& str);
+
 /**
  * @brief Calculate SHA-256 hash of a file
  * @param filePath Path to the file
@@ -23,6 +32,77 @@ std::string sha256(const std::string& str);
  */
 std::string sha256File(const std::string& filePath);
 
+/**
+ * @brief Calculate SHA-256 digest of a file
+ *
+ * Large regular files are hashed through a sequential mmap; anything else
+ * is read in 1 MiB aligned chunks.
+ * @param filePath Path to the file
+ * @return Binary digest
+ */
+Hash256 sha256FileDigest(const std::string& filePath);
+
+/**
+ * @brief Chunk size for the tree-hash content addressing mode
+ */
+constexpr size_t TREE_HASH_CHUNK_SIZE = 1024 * 1024;
+
+/**
+ * @brief Result of hashing a file as a Merkle tree of fixed-size chunks
+ */
+struct FileTreeHash {
+    Hash256 root;                     // Merkle root over chunkHashes
+    std::vector<Hash256> chunkHashes; // Leaf hash of each TREE_HASH_CHUNK_SIZE chunk
+    uint64_t fileSize = 0;
+};
+
+/**
+ * @brief Hash one chunk as a tree leaf
+ * @param data Chunk bytes
+ * @param length Chunk length
+ * @return Leaf hash, domain-separated from interior nodes
+ */
+Hash256 sha256TreeLeaf(const void* data, size_t length);
+
+/**
+ * @brief Combine leaf hashes into a Merkle root
+ *
+ * Interior nodes hash 0x01 || left || right; an unpaired node is carried
+ * up to the next level unchanged.
+ * @param leaves Leaf hashes in order
+ * @return Root hash, or the zero hash for no leaves
+ */
+Hash256 sha256TreeRoot(const std::vector<Hash256>& leaves);
+
+/**
+ * @brief Sibling hashes linking one leaf to the sha256TreeRoot of all leaves
+ * @param leaves Leaf hashes in order
+ * @param index Index of the leaf to prove
+ * @return Sibling hashes from the bottom level up; O(log n) entries
+ * @throws std::out_of_range if index is not a valid leaf
+ */
+std::vector<Hash256> sha256TreeProof(const std::vector<Hash256>& leaves, size_t index);
+
+/**
+ * @brief Recompute a tree root from one leaf and its proof
+ * @param leaf Leaf hash
+ * @param index Index of the leaf
+ * @param leafCount Number of leaves in the tree
+ * @param proof Sibling hashes produced by sha256TreeProof
+ * @return Root to compare against the expected one, or the zero hash if
+ *         the proof does not fit a tree of leafCount leaves
+ */
+Hash256 sha256TreeRootFromProof(const Hash256& leaf, size_t index, size_t leafCount,
+                                const std::vector<Hash256>& proof);
+
+/**
+ * @brief Hash a file as 1 MiB chunks in parallel and combine them into a Merkle root
+ * @param filePath Path to a regular file
+ * @return Root, per-chunk hashes and file size
+ * @throws std::runtime_error if the file cannot be opened or read
+ */
+FileTreeHash sha256FileTree(const std::string& filePath);
+
 /**
  * @brief Generate a simple key pair (public key is derived from private key)
  * @return Pair of (privateKey, publicKey)
@@ -0,0 +1,124 @@
+#include "../include/binary_io.h"
+#include <array>
+#include <cstring>
+
+namespace ahmiyat {
+namespace utils {
+
+namespace {
+
+// Reflected CRC-32 table for the polynomial 0xedb88320
+std::array<uint32_t, 256> makeCrc32Table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t value = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            value = (value & 1) ? (value >> 1) ^ 0xedb88320u : value >> 1;
+        }
+        table[i] = value;
+    }
+    return table;
+}
+
+const std::array<uint32_t, 256> CRC32_TABLE = makeCrc32Table();
+
+} // namespace
+
+void BinaryWriter::writeUint32(uint32_t value) {
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = (value >> (i * 8)) & 0xff;
+    }
+    writeBytes(bytes, sizeof(bytes));
+}
+
+void BinaryWriter::writeUint64(uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = (value >> (i * 8)) & 0xff;
+    }
+    writeBytes(bytes, sizeof(bytes));
+}
+
+void BinaryWriter::writeDouble(double value) {
+    // The exact IEEE-754 bits, so values round-trip unchanged
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeUint64(bits);
+}
+
+void BinaryWriter::writeString(const std::string& value) {
+    writeUint32(static_cast<uint32_t>(value.size()));
+    writeBytes(value.data(), value.size());
+}
+
+bool BinaryReader::readBytes(void* out, size_t length) {
+    if (m_failed || length > m_length - m_position) {
+        m_failed = true;
+        return false;
+    }
+
+    std::memcpy(out, m_data + m_position, length);
+    m_position += length;
+    return true;
+}
+
+bool BinaryReader::readUint32(uint32_t& value) {
+    uint8_t bytes[4];
+    if (!readBytes(bytes, sizeof(bytes))) {
+        return false;
+    }
+
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(bytes[i]) << (i * 8);
+    }
+    return true;
+}
+
+bool BinaryReader::readUint64(uint64_t& value) {
+    uint8_t bytes[8];
+    if (!readBytes(bytes, sizeof(bytes))) {
+        return false;
+    }
+
+    value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+    }
+    return true;
+}
+
+bool BinaryReader::readDouble(double& value) {
+    uint64_t bits;
+    if (!readUint64(bits)) {
+        return false;
+    }
+
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+bool BinaryReader::readString(std::string& value) {
+    uint32_t length;
+    if (!readUint32(length) || length > remaining()) {
+        m_failed = true;
+        return false;
+    }
+
+    value.assign(reinterpret_cast<const char*>(m_data + m_position), length);
+    m_position += length;
+    return true;
+}
+
+uint32_t crc32(const void* data, size_t length, uint32_t crc) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = CRC32_TABLE[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+} // namespace utils
+} // namespace ahmiyat
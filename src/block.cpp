@@ -1,19 +1,28 @@
 #include "../include/block.h"
 #include "../include/utils.h"
+#include "../include/sha256.h"
+#include "../include/miner.h"
+#include "../include/mining_telemetry.h"
+#include "../include/target.h"
 #include <sstream>
 #include <iostream>
 #include <algorithm>
 #include <stdexcept>
+#include <cstring>
 
 // Constructor implementation
-Block::Block(uint32_t indexIn, const std::vector<Transaction>& dataIn, const std::string& previousHashIn)
+Block::Block(uint32_t indexIn, const std::vector<Transaction>& dataIn, const Hash256& previousHashIn,
+             uint32_t targetBitsIn)
     : m_index(indexIn), 
       m_timestamp(std::time(nullptr)), 
       m_transactions(dataIn), 
       m_previousHash(previousHashIn),
+      m_targetBits(targetBitsIn),
       m_nonce(0),
+      m_extraNonce(0),
       m_minerAddress("") {
-    // Calculate the hash immediately upon creation
+    // The body is final once constructed; commit to it, then hash the header
+    updateMerkleRoot();
     m_hash = calculateHash();
 }
 
@@ -21,54 +30,123 @@ Block::Block(uint32_t indexIn, const std::vector<Transaction>& dataIn, const std
 Block::Block() 
     : m_index(0), 
       m_timestamp(std::time(nullptr)), 
+      m_targetBits(DEFAULT_TARGET_BITS),
       m_nonce(0),
+      m_extraNonce(0),
       m_minerAddress("") {
     m_hash = calculateHash();
 }
 
-std::string Block::calculateHash() const {
-    std::stringstream ss;
-    ss << m_index << m_timestamp;
+std::vector<Hash256> Block::calculateTransactionHashes() const {
+    if (m_transactions.size() < 2) {
+        std::vector<Hash256> hashes;
+        for (const auto& tx : m_transactions) {
+            hashes.push_back(tx.calculateHash());
+        }
+        return hashes;
+    }
     
-    // Include all transaction hashes
+    std::vector<std::string> preimages;
+    preimages.reserve(m_transactions.size());
     for (const auto& tx : m_transactions) {
-        ss << tx.calculateHash();
+        preimages.push_back(tx.hashPreimage());
     }
     
-    ss << m_previousHash << m_nonce;
+    return ahmiyat::utils::sha256Batch(preimages);
+}
+
+Hash256 Block::calculateMerkleRoot() const {
+    return ahmiyat::utils::sha256TreeRoot(calculateTransactionHashes());
+}
+
+void Block::updateMerkleRoot() {
+    m_merkleRoot = calculateMerkleRoot();
+}
+
+std::vector<Hash256> Block::getMerkleProof(size_t txIndex) const {
+    return ahmiyat::utils::sha256TreeProof(calculateTransactionHashes(), txIndex);
+}
+
+bool Block::verifyMerkleProof(const Hash256& txHash, size_t txIndex, size_t txCount,
+                              const std::vector<Hash256>& proof, const Hash256& merkleRoot) {
+    if (txIndex >= txCount) {
+        return false;
+    }
     
-    return ahmiyat::utils::sha256(ss.str());
+    return ahmiyat::utils::sha256TreeRootFromProof(txHash, txIndex, txCount, proof) == merkleRoot;
+}
+
+// Little-endian integer encoding, matching Sha256::updateUint32/updateUint64
+static void storeLittleEndian(uint8_t* out, uint64_t value, size_t width) {
+    for (size_t i = 0; i < width; ++i) {
+        out[i] = static_cast<uint8_t>((value >> (i * 8)) & 0xff);
+    }
+}
+
+Block::Header Block::serializeHeader() const {
+    return getHeader().serialize();
+}
+
+BlockHeader Block::getHeader() const {
+    return BlockHeader(*this);
 }
 
-bool Block::mineBlock(int difficulty, const std::string& minerAddress) {
+Hash256 Block::calculateHash() const {
+    Header header = serializeHeader();
+    
+    ahmiyat::utils::Sha256 ctx;
+    ctx.update(header.data(), header.size());
+    return ctx.final();
+}
+
+std::string Block::hashPreimage() const {
+    Header header = serializeHeader();
+    return std::string(reinterpret_cast<const char*>(header.data()), header.size());
+}
+
+Hash256 Block::getTarget() const {
+    Hash256 target;
+    if (!ahmiyat::utils::compactToTarget(m_targetBits, target)) {
+        return Hash256();
+    }
+    return target;
+}
+
+bool Block::hasValidProofOfWork() const {
+    Hash256 target = getTarget();
+    return !target.isZero() && ahmiyat::utils::hashMeetsTarget(m_hash, target);
+}
+
+bool Block::mineBlock(const std::string& minerAddress, size_t threadCount,
+                      const std::atomic<bool>* cancel, std::atomic<uint64_t>* progress,
+                      MiningTelemetry* telemetry) {
     m_minerAddress = minerAddress;
     
-    // Create a string with 'difficulty' number of 0s
-    std::string target(difficulty, '0');
+    if (getTarget().isZero()) {
+        std::cerr << "Invalid block target: 0x" << std::hex << m_targetBits << std::dec << std::endl;
+        return false;
+    }
     
-    std::cout << "Mining block with difficulty " << difficulty << "..." << std::endl;
+    Miner miner(threadCount);
+    MiningResult result = miner.mine(*this, cancel, progress);
+    if (telemetry) {
+        telemetry->record(result, getTarget());
+    }
     
-    do {
-        m_nonce++;
-        m_hash = calculateHash();
-        
-        // Check if we've hit our target (hash starts with the required number of zeros)
-        if (m_hash.substr(0, difficulty) == target) {
-            std::cout << "Block mined: " << m_hash << std::endl;
-            return true;
-        }
-        
-        // Don't run forever if we can't find a valid hash
-        if (m_nonce > 1000000) {
-            std::cerr << "Mining aborted after too many attempts" << std::endl;
-            return false;
-        }
-        
-        // Show progress periodically
-        if (m_nonce % 100000 == 0) {
-            std::cout << "Mining in progress... " << m_nonce << " hashes calculated" << std::endl;
+    if (!result.found) {
+        if (result.cancelled) {
+            std::cerr << "Mining cancelled after " << result.hashesTried << " attempts" << std::endl;
+        } else {
+            std::cerr << "Mining search space exhausted after " << result.hashesTried << " attempts" << std::endl;
         }
-    } while (true);
+        return false;
+    }
+    
+    m_nonce = result.nonce;
+    m_extraNonce = result.extraNonce;
+    m_timestamp = result.timestamp;
+    m_hash = result.hash;
+    return true;
 }
 
 uint32_t Block::getIndex() const {
@@ -79,15 +157,15 @@ time_t Block::getTimestamp() const {
     return m_timestamp;
 }
 
-std::string Block::getPreviousHash() const {
+Hash256 Block::getPreviousHash() const {
     return m_previousHash;
 }
 
-std::string Block::getHash() const {
+Hash256 Block::getHash() const {
     return m_hash;
 }
 
-std::vector<Transaction> Block::getTransactions() const {
+const std::vector<Transaction>& Block::getTransactions() const {
     return m_transactions;
 }
 
@@ -104,9 +182,12 @@ std::string Block::toJson() const {
     ss << "    {\n";
     ss << "      \"index\": " << m_index << ",\n";
     ss << "      \"timestamp\": " << m_timestamp << ",\n";
-    ss << "      \"previousHash\": \"" << ahmiyat::utils::jsonEscape(m_previousHash) << "\",\n";
-    ss << "      \"hash\": \"" << ahmiyat::utils::jsonEscape(m_hash) << "\",\n";
+    ss << "      \"previousHash\": \"" << ahmiyat::utils::jsonEscape(m_previousHash.toHex()) << "\",\n";
+    ss << "      \"merkleRoot\": \"" << ahmiyat::utils::jsonEscape(m_merkleRoot.toHex()) << "\",\n";
+    ss << "      \"hash\": \"" << ahmiyat::utils::jsonEscape(m_hash.toHex()) << "\",\n";
+    ss << "      \"targetBits\": " << m_targetBits << ",\n";
     ss << "      \"nonce\": " << m_nonce << ",\n";
+    ss << "      \"extraNonce\": " << m_extraNonce << ",\n";
     ss << "      \"minerAddress\": \"" << ahmiyat::utils::jsonEscape(m_minerAddress) << "\",\n";
     ss << "      \"transactions\": [\n";
     
@@ -160,9 +241,12 @@ Block Block::fromJson(const std::string& json) {
         // Extract values
         std::string indexStr = extractValue("index");
         std::string timestampStr = extractValue("timestamp");
-        block.m_previousHash = extractValue("previousHash");
-        block.m_hash = extractValue("hash");
+        Hash256::tryFromHex(extractValue("previousHash"), block.m_previousHash);
+        Hash256::tryFromHex(extractValue("hash"), block.m_hash);
+        bool hasMerkleRoot = Hash256::tryFromHex(extractValue("merkleRoot"), block.m_merkleRoot);
         std::string nonceStr = extractValue("nonce");
+        std::string extraNonceStr = extractValue("extraNonce");
+        std::string targetBitsStr = extractValue("targetBits");
         block.m_minerAddress = extractValue("minerAddress");
         
         // Convert to appropriate types
@@ -175,7 +259,15 @@ Block Block::fromJson(const std::string& json) {
         }
         
         if (!nonceStr.empty()) {
-            block.m_nonce = std::stoi(nonceStr);
+            block.m_nonce = static_cast<uint32_t>(std::stoul(nonceStr));
+        }
+        
+        if (!extraNonceStr.empty()) {
+            block.m_extraNonce = static_cast<uint32_t>(std::stoul(extraNonceStr));
+        }
+        
+        if (!targetBitsStr.empty()) {
+            block.m_targetBits = static_cast<uint32_t>(std::stoul(targetBitsStr));
         }
         
         // Extract transactions
@@ -205,12 +297,138 @@ Block Block::fromJson(const std::string& json) {
             }
         }
         
+        // Older chain files carry no root; derive it from the body
+        if (!hasMerkleRoot) {
+            block.updateMerkleRoot();
+        }
+        
         return block;
     } catch (const std::exception& e) {
         std::cerr << "Error parsing block JSON: " << e.what() << std::endl;
         // Create an empty block and return it
         Block emptyBlock;
-        emptyBlock.m_previousHash = "0";
+        emptyBlock.m_previousHash = Hash256();
         return emptyBlock;
     }
 }
+
+std::string Block::serialize() const {
+    Header header = serializeHeader();
+    
+    ahmiyat::utils::BinaryWriter writer;
+    writer.reserve(HEADER_SIZE + Hash256::SIZE + 64 + m_transactions.size() * 160);
+    writer.writeBytes(header.data(), header.size());
+    writer.writeHash(m_hash);
+    writer.writeString(m_minerAddress);
+    writer.writeUint32(static_cast<uint32_t>(m_transactions.size()));
+    for (const auto& tx : m_transactions) {
+        tx.serialize(writer);
+    }
+    
+    return std::move(writer.bytes());
+}
+
+bool Block::deserialize(const uint8_t* data, size_t length, Block& block) {
+    ahmiyat::utils::BinaryReader reader(data, length);
+    
+    // The header fields are fixed-width little-endian, in layout order
+    uint64_t timestamp = 0;
+    reader.readUint32(block.m_index);
+    reader.readUint64(timestamp);
+    reader.readHash(block.m_previousHash);
+    reader.readHash(block.m_merkleRoot);
+    reader.readUint32(block.m_targetBits);
+    reader.readUint32(block.m_nonce);
+    reader.readUint32(block.m_extraNonce);
+    reader.readHash(block.m_hash);
+    reader.readString(block.m_minerAddress);
+    
+    uint32_t txCount = 0;
+    if (!reader.readUint32(txCount)) {
+        return false;
+    }
+    block.m_timestamp = static_cast<time_t>(timestamp);
+    
+    // Each transaction takes well over one byte, which bounds a corrupt count
+    if (txCount > reader.remaining()) {
+        return false;
+    }
+    block.m_transactions.clear();
+    block.m_transactions.resize(txCount);
+    for (auto& tx : block.m_transactions) {
+        if (!Transaction::deserialize(reader, tx)) {
+            return false;
+        }
+    }
+    
+    return reader.remaining() == 0;
+}
+
+BlockHeader::BlockHeader(const Block& block)
+    : m_index(block.getIndex()),
+      m_timestamp(block.getTimestamp()),
+      m_previousHash(block.getPreviousHash()),
+      m_merkleRoot(block.getMerkleRoot()),
+      m_targetBits(block.getTargetBits()),
+      m_nonce(block.getNonce()),
+      m_extraNonce(block.getExtraNonce()),
+      m_hash(block.getHash()),
+      m_transactionCount(static_cast<uint32_t>(block.getTransactions().size())) {
+}
+
+Block::Header BlockHeader::serialize() const {
+    Block::Header header{};
+    
+    storeLittleEndian(header.data() + Block::HEADER_INDEX_OFFSET, m_index, sizeof(uint32_t));
+    storeLittleEndian(header.data() + Block::HEADER_TIMESTAMP_OFFSET, static_cast<uint64_t>(m_timestamp),
+                      sizeof(uint64_t));
+    std::memcpy(header.data() + Block::HEADER_PREVIOUS_HASH_OFFSET, m_previousHash.data(), Hash256::SIZE);
+    
+    std::memcpy(header.data() + Block::HEADER_MERKLE_ROOT_OFFSET, m_merkleRoot.data(), Hash256::SIZE);
+    storeLittleEndian(header.data() + Block::HEADER_TARGET_BITS_OFFSET, m_targetBits, sizeof(uint32_t));
+    
+    storeLittleEndian(header.data() + Block::HEADER_NONCE_OFFSET, m_nonce, sizeof(uint32_t));
+    storeLittleEndian(header.data() + Block::HEADER_EXTRA_NONCE_OFFSET, m_extraNonce, sizeof(uint32_t));
+    
+    return header;
+}
+
+std::string BlockHeader::hashPreimage() const {
+    Block::Header header = serialize();
+    return std::string(reinterpret_cast<const char*>(header.data()), header.size());
+}
+
+Hash256 BlockHeader::getTarget() const {
+    Hash256 target;
+    if (!ahmiyat::utils::compactToTarget(m_targetBits, target)) {
+        return Hash256();
+    }
+    return target;
+}
+
+bool BlockHeader::hasValidProofOfWork() const {
+    Hash256 target = getTarget();
+    return !target.isZero() && ahmiyat::utils::hashMeetsTarget(m_hash, target);
+}
+
+bool BlockHeader::deserialize(const uint8_t* data, size_t length, BlockHeader& header) {
+    ahmiyat::utils::BinaryReader reader(data, length);
+    
+    // Same prefix Block::deserialize reads; the miner address is skipped
+    // and the transactions are left undecoded
+    uint64_t timestamp = 0;
+    std::string minerAddress;
+    reader.readUint32(header.m_index);
+    reader.readUint64(timestamp);
+    reader.readHash(header.m_previousHash);
+    reader.readHash(header.m_merkleRoot);
+    reader.readUint32(header.m_targetBits);
+    reader.readUint32(header.m_nonce);
+    reader.readUint32(header.m_extraNonce);
+    reader.readHash(header.m_hash);
+    reader.readString(minerAddress);
+    reader.readUint32(header.m_transactionCount);
+    
+    header.m_timestamp = static_cast<time_t>(timestamp);
+    return !reader.failed();
+}
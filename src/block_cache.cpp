@@ -0,0 +1,145 @@
+#include "../include/block_cache.h"
+#include "../include/block_store.h"
+
+BlockCache::BlockCache(size_t capacity)
+    : m_capacity(capacity),
+      m_hits(0),
+      m_misses(0),
+      m_evictions(0) {
+}
+
+void BlockCache::setSource(std::shared_ptr<const BlockStore> store) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_source = std::move(store);
+    evictLocked();
+}
+
+std::shared_ptr<const Block> BlockCache::get(size_t height) {
+    std::shared_ptr<const BlockStore> source;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(height);
+        if (it != m_entries.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            m_hits++;
+            return *it->second;
+        }
+        m_misses++;
+        source = m_source;
+    }
+
+    // Read without the lock; two threads missing the same block may both
+    // read it, and the second keeps the first's copy
+    Block block;
+    if (!source || !source->readBlock(height, block)) {
+        return nullptr;
+    }
+    auto loaded = std::make_shared<const Block>(std::move(block));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(height);
+    if (it != m_entries.end()) {
+        return *it->second;
+    }
+    insertLocked(loaded);
+    evictLocked();
+    return loaded;
+}
+
+std::shared_ptr<const Block> BlockCache::read(size_t height) const {
+    std::shared_ptr<const BlockStore> source;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(height);
+        if (it != m_entries.end()) {
+            return *it->second;
+        }
+        source = m_source;
+    }
+
+    Block block;
+    if (!source || !source->readBlock(height, block)) {
+        return nullptr;
+    }
+    return std::make_shared<const Block>(std::move(block));
+}
+
+void BlockCache::insert(std::shared_ptr<const Block> block) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(block->getIndex());
+    if (it != m_entries.end()) {
+        m_lru.erase(it->second);
+        m_entries.erase(it);
+    }
+    insertLocked(block);
+    evictLocked();
+}
+
+void BlockCache::truncate(size_t height) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_lru.begin(); it != m_lru.end();) {
+        if ((*it)->getIndex() >= height) {
+            m_entries.erase((*it)->getIndex());
+            it = m_lru.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void BlockCache::prune(size_t height) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_lru.begin(); it != m_lru.end();) {
+        if ((*it)->getIndex() < height) {
+            m_entries.erase((*it)->getIndex());
+            it = m_lru.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t BlockCache::getPrunedHeight() const {
+    std::shared_ptr<const BlockStore> source;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        source = m_source;
+    }
+    return source ? source->getPrunedHeight() : 0;
+}
+
+BlockCacheStats BlockCache::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    BlockCacheStats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    stats.size = m_entries.size();
+    stats.capacity = m_capacity;
+    return stats;
+}
+
+void BlockCache::insertLocked(const Entry& block) {
+    m_lru.push_front(block);
+    m_entries[block->getIndex()] = m_lru.begin();
+}
+
+void BlockCache::evictLocked() {
+    if (!m_source || m_entries.size() <= m_capacity) {
+        return;
+    }
+
+    // Least recently used first, skipping bodies the store does not hold
+    // yet; those can only be read from here
+    size_t stored = m_source->size();
+    auto it = m_lru.end();
+    while (m_entries.size() > m_capacity && it != m_lru.begin()) {
+        --it;
+        if ((*it)->getIndex() < stored) {
+            m_entries.erase((*it)->getIndex());
+            it = m_lru.erase(it);
+            m_evictions++;
+        }
+    }
+}
@@ -0,0 +1,704 @@
+#include "../include/block_store.h"
+#include "../include/binary_io.h"
+#include "../include/file_mapping.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Header of one record; the payload follows it
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t length;
+    uint32_t crc;
+};
+
+bool readRecordHeader(const uint8_t* data, size_t length, RecordHeader& header) {
+    ahmiyat::utils::BinaryReader reader(data, length);
+    reader.readUint32(header.magic);
+    reader.readUint32(header.length);
+    reader.readUint32(header.crc);
+    return !reader.failed();
+}
+
+// Walk the records of a file, passing each payload and its offset to visit
+// until a record does not check out. validLength receives where the intact
+// records end and damage why the walk stopped early (empty if it did not);
+// cutShort is set if that record runs past the end of the file
+template <typename Visit>
+bool scanRecords(const std::string& path, uint32_t magic, size_t& validLength, std::string& damage,
+                 bool& cutShort, Visit visit) {
+    ahmiyat::utils::FileDescriptor file(path);
+    struct stat st;
+    if (file.fd < 0 || ::fstat(file.fd, &st) != 0) {
+        std::cerr << "Failed to open block store file " << path << std::endl;
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    ahmiyat::utils::FileMapping mapping(file.fd, fileSize, MADV_SEQUENTIAL);
+    if (fileSize > 0 && !mapping.valid()) {
+        std::cerr << "Failed to map block store file " << path << std::endl;
+        return false;
+    }
+
+    // Records are back to back; stop at the first one that does not check out
+    const uint8_t* data = mapping.bytes();
+    validLength = 0;
+    cutShort = false;
+    while (validLength < fileSize) {
+        size_t remaining = fileSize - validLength;
+        RecordHeader header;
+        if (!readRecordHeader(data + validLength, remaining, header)) {
+            damage = "incomplete record header";
+            cutShort = true;
+            break;
+        }
+        if (header.magic != magic) {
+            damage = "bad record magic";
+            break;
+        }
+        if (header.length > remaining - BlockStore::RECORD_HEADER_SIZE) {
+            damage = "incomplete record";
+            cutShort = true;
+            break;
+        }
+
+        const uint8_t* payload = data + validLength + BlockStore::RECORD_HEADER_SIZE;
+        if (ahmiyat::utils::crc32(payload, header.length) != header.crc) {
+            damage = "checksum mismatch";
+            break;
+        }
+        if (!visit(payload, header.length, validLength)) {
+            damage = "undecodable record";
+            break;
+        }
+        validLength += BlockStore::RECORD_HEADER_SIZE + header.length;
+    }
+    return true;
+}
+
+// Cut a file back to its intact records. A crash can only cut short the
+// last record written, so that is the one repair made; a complete record
+// that fails its checks, or damage in any other file, is real corruption
+// and would take every block after it along if truncated
+bool repairTail(const std::string& path, bool last, size_t validLength, const std::string& damage,
+                bool cutShort) {
+    if (damage.empty()) {
+        return true;
+    }
+    if (!last || !cutShort) {
+        std::cerr << "Block store file " << path << " is corrupt at offset " << validLength << " (" << damage
+                  << ")" << std::endl;
+        return false;
+    }
+
+    std::cerr << "Truncating damaged tail of " << path << " at offset " << validLength << " (" << damage
+              << ")" << std::endl;
+    if (::truncate(path.c_str(), static_cast<off_t>(validLength)) != 0) {
+        std::cerr << "Failed to truncate block store file " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Length of the part of a block payload that BlockHeader::deserialize
+// reads: the fixed header, the hash, the miner address and the
+// transaction count
+bool headerPrefixLength(const uint8_t* payload, size_t length, size_t& prefix) {
+    ahmiyat::utils::BinaryReader reader(payload, length);
+    uint8_t fixed[Block::HEADER_SIZE + Hash256::SIZE];
+    std::string minerAddress;
+    uint32_t transactionCount = 0;
+    reader.readBytes(fixed, sizeof(fixed));
+    reader.readString(minerAddress);
+    reader.readUint32(transactionCount);
+    if (reader.failed()) {
+        return false;
+    }
+
+    prefix = length - reader.remaining();
+    return true;
+}
+
+} // namespace
+
+BlockStore::BlockStore(const std::string& directory, uint64_t segmentSize)
+    : m_directory(directory),
+      m_segmentSize(segmentSize),
+      m_fd(-1),
+      m_segment(0),
+      m_segmentLength(0),
+      m_appendSequence(0),
+      m_prunedHeight(0),
+      m_headerCount(0),
+      m_headersLength(0),
+      m_syncedSequence(0),
+      m_syncing(false) {
+}
+
+BlockStore::~BlockStore() {
+    closeAppendSegment();
+}
+
+bool BlockStore::open(std::vector<BlockHeader>& headers) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::error_code error;
+    fs::create_directories(m_directory, error);
+    if (error) {
+        std::cerr << "Failed to create block store directory: " << error.message() << std::endl;
+        return false;
+    }
+
+    std::vector<uint32_t> segments;
+    if (!listSegments(segments)) {
+        return false;
+    }
+
+    // Pruned headers first, then the segments holding the remaining bodies
+    headers.clear();
+    m_index.clear();
+    m_heightByHash.clear();
+    if (!loadHeaders(headers)) {
+        return false;
+    }
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (!loadSegment(segments[i], i + 1 == segments.size(), headers)) {
+            return false;
+        }
+    }
+
+    m_prunedHeight = 0;
+    while (m_prunedHeight < m_index.size() && m_index[m_prunedHeight].segment == PRUNED_SEGMENT) {
+        m_prunedHeight++;
+    }
+
+    closeAppendSegment();
+    if (!openAppendSegment(segments.empty() ? 0 : segments.back())) {
+        return false;
+    }
+    return !segments.empty() || syncDirectory();
+}
+
+bool BlockStore::listSegments(std::vector<uint32_t>& segments) const {
+    // Pruning deletes the oldest segments, so numbering need not start at 0
+    std::error_code error;
+    for (fs::directory_iterator it(m_directory, error), end; !error && it != end; it.increment(error)) {
+        std::string name = it->path().filename().string();
+        unsigned int segment = 0;
+        if (std::sscanf(name.c_str(), "blocks-%u.dat", &segment) == 1 &&
+            fs::path(segmentPath(segment)).filename() == name) {
+            segments.push_back(segment);
+        }
+    }
+    if (error) {
+        std::cerr << "Failed to list block store directory: " << error.message() << std::endl;
+        return false;
+    }
+
+    std::sort(segments.begin(), segments.end());
+    for (size_t i = 1; i < segments.size(); ++i) {
+        if (segments[i] != segments[i - 1] + 1) {
+            std::cerr << "Block store segment " << segmentPath(segments[i - 1] + 1) << " is missing" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BlockStore::loadHeaders(std::vector<BlockHeader>& headers) {
+    m_headerCount = 0;
+    m_headersLength = 0;
+    std::string path = headersPath();
+    if (!fs::exists(path)) {
+        return true;
+    }
+
+    size_t validLength = 0;
+    std::string damage;
+    bool cutShort = false;
+    bool scanned = scanRecords(path, HEADER_RECORD_MAGIC, validLength, damage, cutShort,
+                               [&](const uint8_t* payload, uint32_t length, size_t offset) {
+        BlockHeader blockHeader;
+        if (!BlockHeader::deserialize(payload, length, blockHeader) || blockHeader.getIndex() != headers.size()) {
+            return false;
+        }
+
+        m_heightByHash[blockHeader.getHash()] = m_index.size();
+        m_index.push_back({PRUNED_SEGMENT, offset, length, blockHeader.getHash()});
+        headers.push_back(blockHeader);
+        return true;
+    });
+    if (!scanned || !repairTail(path, true, validLength, damage, cutShort)) {
+        return false;
+    }
+
+    m_headerCount = headers.size();
+    m_headersLength = validLength;
+    return true;
+}
+
+bool BlockStore::loadSegment(uint32_t segment, bool last, std::vector<BlockHeader>& headers) {
+    std::string path = segmentPath(segment);
+    size_t validLength = 0;
+    std::string damage;
+    bool cutShort = false;
+    bool scanned = scanRecords(path, RECORD_MAGIC, validLength, damage, cutShort,
+                               [&](const uint8_t* payload, uint32_t length, size_t offset) {
+        BlockHeader blockHeader;
+        if (!BlockHeader::deserialize(payload, length, blockHeader)) {
+            return false;
+        }
+
+        // A prune interrupted between archiving the headers and deleting
+        // the segment leaves both; the body stays readable until the next prune
+        size_t height = blockHeader.getIndex();
+        if (height < m_headerCount && m_index[height].segment == PRUNED_SEGMENT &&
+            m_index[height].hash == blockHeader.getHash()) {
+            m_index[height] = {segment, offset, length, blockHeader.getHash()};
+            return true;
+        }
+        if (height != headers.size()) {
+            return false;
+        }
+
+        m_heightByHash[blockHeader.getHash()] = m_index.size();
+        m_index.push_back({segment, offset, length, blockHeader.getHash()});
+        headers.push_back(blockHeader);
+        return true;
+    });
+    return scanned && repairTail(path, last, validLength, damage, cutShort);
+}
+
+bool BlockStore::append(const Block& block, uint64_t& sequence) {
+    // Encode outside the lock; only the write is serialized
+    std::string payload = block.serialize();
+    ahmiyat::utils::BinaryWriter record;
+    record.reserve(RECORD_HEADER_SIZE + payload.size());
+    record.writeUint32(RECORD_MAGIC);
+    record.writeUint32(static_cast<uint32_t>(payload.size()));
+    record.writeUint32(ahmiyat::utils::crc32(payload.data(), payload.size()));
+    record.writeBytes(payload.data(), payload.size());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0) {
+        std::cerr << "Block store is not open" << std::endl;
+        return false;
+    }
+    if (block.getIndex() != m_index.size()) {
+        std::cerr << "Block store expected height " << m_index.size() << ", got " << block.getIndex()
+                  << std::endl;
+        return false;
+    }
+
+    // Start a new segment once this one is full. The old one is flushed
+    // first, so sync() only ever needs to flush the current segment
+    if (m_segmentLength > 0 && m_segmentLength + record.size() > m_segmentSize) {
+        if (::fdatasync(m_fd) != 0) {
+            std::cerr << "Failed to flush block store segment" << std::endl;
+            return false;
+        }
+        uint32_t next = m_segment + 1;
+        closeAppendSegment();
+        if (!openAppendSegment(next) || !syncDirectory()) {
+            return false;
+        }
+    }
+
+    if (!ahmiyat::utils::writeAll(m_fd, record.bytes().data(), record.size())) {
+        // Cut off whatever part of the record made it to the file
+        std::cerr << "Failed to write block to block store" << std::endl;
+        if (::ftruncate(m_fd, static_cast<off_t>(m_segmentLength)) != 0) {
+            std::cerr << "Failed to roll back partial block store record" << std::endl;
+        }
+        return false;
+    }
+
+    m_heightByHash[block.getHash()] = m_index.size();
+    m_index.push_back({m_segment, m_segmentLength, static_cast<uint32_t>(payload.size()), block.getHash()});
+    m_segmentLength += record.size();
+    sequence = ++m_appendSequence;
+    return true;
+}
+
+bool BlockStore::sync(uint64_t sequence) {
+    std::unique_lock<std::mutex> syncLock(m_syncMutex);
+    while (m_syncedSequence < sequence) {
+        // A flush is running; it may cover this sequence, otherwise the
+        // next one will
+        if (m_syncing) {
+            m_syncDone.wait(syncLock);
+            continue;
+        }
+        m_syncing = true;
+
+        // Everything appended so far rides on this flush. The descriptor is
+        // duplicated so a segment roll can close the original meanwhile
+        uint64_t target;
+        int fd;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            target = m_appendSequence;
+            fd = m_fd >= 0 ? ::dup(m_fd) : -1;
+        }
+
+        syncLock.unlock();
+        bool flushed = fd >= 0 && ::fdatasync(fd) == 0;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        syncLock.lock();
+
+        m_syncing = false;
+        if (flushed) {
+            m_syncedSequence = std::max(m_syncedSequence, target);
+        }
+        m_syncDone.notify_all();
+
+        if (!flushed) {
+            std::cerr << "Failed to flush block store" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool BlockStore::syncAll() {
+    uint64_t sequence;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sequence = m_appendSequence;
+    }
+    return sync(sequence);
+}
+
+bool BlockStore::truncate(size_t height) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (height >= m_index.size()) {
+        return true;
+    }
+    if (height < m_headerCount) {
+        std::cerr << "Cannot truncate the block store below its pruned blocks (" << m_headerCount << ")"
+                  << std::endl;
+        return false;
+    }
+
+    // Remove the segments after the one holding the new end, then cut that one
+    const Location& end = m_index[height];
+    uint32_t segment = end.segment;
+    uint64_t offset = end.offset;
+    uint32_t lastSegment = m_segment;
+    closeAppendSegment();
+
+    for (uint32_t s = lastSegment; s > segment; --s) {
+        std::remove(segmentPath(s).c_str());
+    }
+    if (::truncate(segmentPath(segment).c_str(), static_cast<off_t>(offset)) != 0) {
+        std::cerr << "Failed to truncate block store segment" << std::endl;
+        return false;
+    }
+
+    for (size_t h = height; h < m_index.size(); ++h) {
+        m_heightByHash.erase(m_index[h].hash);
+    }
+    m_index.resize(height);
+
+    if (!openAppendSegment(segment) || ::fdatasync(m_fd) != 0) {
+        return false;
+    }
+    return syncDirectory();
+}
+
+bool BlockStore::prune(size_t height) {
+    std::lock_guard<std::mutex> pruneLock(m_pruneMutex);
+
+    // Whole segments below height, oldest first, and the records in them
+    // whose headers are not archived yet
+    std::vector<uint32_t> segments;
+    std::vector<Location> unarchived;
+    size_t prunedHeight;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        height = std::min(height, m_index.size());
+        prunedHeight = m_prunedHeight;
+        while (prunedHeight < height && segments.size() < MAX_PRUNE_SEGMENTS) {
+            uint32_t segment = m_index[prunedHeight].segment;
+            size_t end = prunedHeight;
+            while (end < m_index.size() && m_index[end].segment == segment) {
+                end++;
+            }
+            if (segment == m_segment || end > height) {
+                break;
+            }
+
+            for (size_t h = std::max(prunedHeight, m_headerCount); h < end; ++h) {
+                unarchived.push_back(m_index[h]);
+            }
+            segments.push_back(segment);
+            prunedHeight = end;
+        }
+    }
+    if (segments.empty()) {
+        return true;
+    }
+
+    // The segments are full, so they no longer change; read them and write
+    // the headers without blocking appends. The headers are durable before
+    // any body is deleted
+    ahmiyat::utils::BinaryWriter records;
+    if (!archiveHeaders(unarchived, records)) {
+        return false;
+    }
+    if (records.size() > 0) {
+        ahmiyat::utils::FileDescriptor file(headersPath(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC);
+        if (file.fd < 0 || !ahmiyat::utils::writeAll(file.fd, records.bytes().data(), records.size()) ||
+            ::fdatasync(file.fd) != 0) {
+            std::cerr << "Failed to archive pruned block headers" << std::endl;
+            if (file.fd >= 0 && ::ftruncate(file.fd, static_cast<off_t>(m_headersLength)) != 0) {
+                std::cerr << "Failed to roll back partial block header records" << std::endl;
+            }
+            return false;
+        }
+        if (m_headersLength == 0 && !syncDirectory()) {
+            return false;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t h = m_prunedHeight; h < prunedHeight; ++h) {
+            m_index[h].segment = PRUNED_SEGMENT;
+        }
+        m_prunedHeight = prunedHeight;
+        m_headerCount = std::max(m_headerCount, prunedHeight);
+        m_headersLength += records.size();
+    }
+
+    // Oldest first, stopping at the first failure, so the segments left
+    // stay consecutive; one left behind is pruned again on the next call
+    // after a restart
+    for (uint32_t segment : segments) {
+        if (std::remove(segmentPath(segment).c_str()) != 0) {
+            std::cerr << "Failed to delete pruned block store segment " << segmentPath(segment) << std::endl;
+            break;
+        }
+    }
+    return syncDirectory();
+}
+
+bool BlockStore::archiveHeaders(const std::vector<Location>& locations,
+                                ahmiyat::utils::BinaryWriter& records) const {
+    size_t i = 0;
+    while (i < locations.size()) {
+        uint32_t segment = locations[i].segment;
+        std::string path = segmentPath(segment);
+        ahmiyat::utils::FileDescriptor file(path);
+        struct stat st;
+        if (file.fd < 0 || ::fstat(file.fd, &st) != 0) {
+            std::cerr << "Failed to open block store segment " << path << std::endl;
+            return false;
+        }
+
+        size_t fileSize = static_cast<size_t>(st.st_size);
+        ahmiyat::utils::FileMapping mapping(file.fd, fileSize, MADV_SEQUENTIAL);
+        if (fileSize > 0 && !mapping.valid()) {
+            std::cerr << "Failed to map block store segment " << path << std::endl;
+            return false;
+        }
+
+        // Each header record is the start of the block's payload, so it
+        // decodes with BlockHeader::deserialize like a full record
+        for (; i < locations.size() && locations[i].segment == segment; ++i) {
+            const Location& location = locations[i];
+            const uint8_t* payload = mapping.bytes() + location.offset + RECORD_HEADER_SIZE;
+            size_t prefix = 0;
+            if (location.offset + RECORD_HEADER_SIZE + location.length > fileSize ||
+                !headerPrefixLength(payload, location.length, prefix)) {
+                std::cerr << "Block store segment " << path << " is corrupt at offset " << location.offset
+                          << std::endl;
+                return false;
+            }
+
+            records.writeUint32(HEADER_RECORD_MAGIC);
+            records.writeUint32(static_cast<uint32_t>(prefix));
+            records.writeUint32(ahmiyat::utils::crc32(payload, prefix));
+            records.writeBytes(payload, prefix);
+        }
+    }
+    return true;
+}
+
+bool BlockStore::appendMemoryProofs(const std::vector<MemoryProof>& proofs, const std::vector<Hash256>& hashes) {
+    ahmiyat::utils::BinaryWriter records;
+    for (size_t i = 0; i < proofs.size(); ++i) {
+        ahmiyat::utils::BinaryWriter payload;
+        proofs[i].serialize(payload);
+        payload.writeHash(hashes[i]);
+
+        records.writeUint32(MEMORY_PROOF_RECORD_MAGIC);
+        records.writeUint32(static_cast<uint32_t>(payload.size()));
+        records.writeUint32(ahmiyat::utils::crc32(payload.bytes().data(), payload.size()));
+        records.writeBytes(payload.bytes().data(), payload.size());
+    }
+    if (records.size() == 0) {
+        return true;
+    }
+
+    // A failed write is cut back off, so the log never ends in a record
+    // nobody was told about
+    std::lock_guard<std::mutex> lock(m_memoryProofMutex);
+    std::string path = memoryProofsPath();
+    ahmiyat::utils::FileDescriptor file(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC);
+    struct stat st;
+    if (file.fd < 0 || ::fstat(file.fd, &st) != 0) {
+        std::cerr << "Failed to open memory proof log " << path << std::endl;
+        return false;
+    }
+    if (!ahmiyat::utils::writeAll(file.fd, records.bytes().data(), records.size()) || ::fdatasync(file.fd) != 0) {
+        std::cerr << "Failed to write memory proof log " << path << std::endl;
+        if (::ftruncate(file.fd, st.st_size) != 0) {
+            std::cerr << "Failed to roll back partial memory proof records" << std::endl;
+        }
+        return false;
+    }
+    return st.st_size > 0 || syncDirectory();
+}
+
+bool BlockStore::loadMemoryProofs(std::vector<MemoryProof>& proofs, std::vector<Hash256>& hashes) {
+    std::lock_guard<std::mutex> lock(m_memoryProofMutex);
+    std::string path = memoryProofsPath();
+    if (!fs::exists(path)) {
+        return true;
+    }
+
+    size_t validLength = 0;
+    std::string damage;
+    bool cutShort = false;
+    bool scanned = scanRecords(path, MEMORY_PROOF_RECORD_MAGIC, validLength, damage, cutShort,
+                               [&](const uint8_t* payload, uint32_t length, size_t) {
+        ahmiyat::utils::BinaryReader reader(payload, length);
+        MemoryProof proof;
+        Hash256 hash;
+        if (!MemoryProof::deserialize(reader, proof) || !reader.readHash(hash) || reader.remaining() != 0) {
+            return false;
+        }
+
+        proofs.push_back(std::move(proof));
+        hashes.push_back(hash);
+        return true;
+    });
+    return scanned && repairTail(path, true, validLength, damage, cutShort);
+}
+
+bool BlockStore::readBlock(size_t height, Block& block) const {
+    Location location;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (height >= m_index.size() || m_index[height].segment == PRUNED_SEGMENT) {
+            return false;
+        }
+        location = m_index[height];
+    }
+
+    ahmiyat::utils::FileDescriptor file(segmentPath(location.segment));
+    if (file.fd < 0) {
+        // Pruned since the location was looked up
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (height >= m_prunedHeight) {
+            std::cerr << "Failed to open block store segment" << std::endl;
+        }
+        return false;
+    }
+
+    std::string record(RECORD_HEADER_SIZE + location.length, '\0');
+    ssize_t result = ::pread(file.fd, &record[0], record.size(), static_cast<off_t>(location.offset));
+    if (result != static_cast<ssize_t>(record.size())) {
+        std::cerr << "Failed to read block " << height << " from block store" << std::endl;
+        return false;
+    }
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(record.data());
+    const uint8_t* payload = data + RECORD_HEADER_SIZE;
+    RecordHeader header;
+    if (!readRecordHeader(data, record.size(), header) || header.magic != RECORD_MAGIC ||
+        header.length != location.length || ahmiyat::utils::crc32(payload, header.length) != header.crc ||
+        !Block::deserialize(payload, header.length, block)) {
+        std::cerr << "Block " << height << " in block store is corrupt" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool BlockStore::findHeight(const Hash256& hash, size_t& height) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_heightByHash.find(hash);
+    if (it == m_heightByHash.end()) {
+        return false;
+    }
+
+    height = it->second;
+    return true;
+}
+
+size_t BlockStore::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index.size();
+}
+
+size_t BlockStore::getPrunedHeight() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_prunedHeight;
+}
+
+std::string BlockStore::segmentPath(uint32_t segment) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "blocks-%06u.dat", segment);
+    return (fs::path(m_directory) / name).string();
+}
+
+std::string BlockStore::headersPath() const {
+    return (fs::path(m_directory) / "headers.dat").string();
+}
+
+std::string BlockStore::memoryProofsPath() const {
+    return (fs::path(m_directory) / "memory_proofs.dat").string();
+}
+
+bool BlockStore::openAppendSegment(uint32_t segment) {
+    std::string path = segmentPath(segment);
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    struct stat st;
+    if (m_fd < 0 || ::fstat(m_fd, &st) != 0) {
+        std::cerr << "Failed to open block store segment " << path << " for writing" << std::endl;
+        closeAppendSegment();
+        return false;
+    }
+
+    m_segment = segment;
+    m_segmentLength = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+void BlockStore::closeAppendSegment() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool BlockStore::syncDirectory() const {
+    // Makes a newly created segment's directory entry durable
+    if (!ahmiyat::utils::syncDirectory(m_directory)) {
+        std::cerr << "Failed to flush block store directory" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -1,78 +1,357 @@
 #include "../include/blockchain.h"
 #include "../include/utils.h"
-#include <stdexcept>
+#include "../include/sha256.h"
+#include "../include/thread_pool.h"
+#include "../include/target.h"
+#include "../include/block_store.h"
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <chrono>
 
-Blockchain::Blockchain() : m_miningReward(50.0) {
-    // Create the genesis block
-    m_chain.push_back(createGenesisBlock());
+// Credit the recipient and debit the sender of a transaction
+static void applyBalanceChange(std::unordered_map<std::string, double>& balances, const Transaction& tx) {
+    balances[tx.getFromAddress()] -= tx.getAmount();
+    balances[tx.getToAddress()] += tx.getAmount();
+}
+
+// The validation checkpoint and state snapshot are kept beside the block
+// store's segments
+static std::string checkpointPath(const std::string& directory) {
+    return (std::filesystem::path(directory) / "checkpoint").string();
+}
+
+static std::string statePath(const std::string& directory) {
+    return (std::filesystem::path(directory) / "state").string();
+}
+
+// Whether a state snapshot was taken from a prefix of these blocks
+static bool stateCoversChain(const StateSnapshot& state, const std::vector<BlockHeader>& headers) {
+    return state.height > 0 && state.height <= headers.size() &&
+           headers[state.height - 1].getHash() == state.tipHash;
+}
+
+Blockchain::Blockchain()
+    : m_chain(std::make_shared<const ChainSnapshot>()),
+      m_miningReward(50.0),
+      m_pruneDepth(NO_PRUNING) {
+    // Create the genesis block; it cannot be validated, so the checkpoint
+    // starts just above it
+    appendBlock(createGenesisBlock());
+    m_validationCheckpoint = {1, m_chain->back().getHash()};
+}
+
+Blockchain::~Blockchain() {
+    // Blocks were flushed as they were submitted; this records how much of
+    // the chain is validated and the state it leads to, so the next start
+    // can skip both
+    if (m_blockStore) {
+        saveValidationCheckpoint(checkpointPath(m_blockStore->getDirectory()));
+        saveStateSnapshot();
+    }
 }
 
 Block Blockchain::createGenesisBlock() {
     // The first block has no previous hash
-    return Block(0, std::vector<Transaction>(), "0");
+    return Block(0, std::vector<Transaction>(), Hash256());
 }
 
 Block Blockchain::getLatestBlock() const {
-    std::lock_guard<std::mutex> lock(m_chainMutex);
-    return m_chain.back();
+    std::shared_ptr<const Block> block = getBlock(getChainSnapshot()->size() - 1);
+    return block ? *block : Block();
 }
 
-bool Blockchain::addBlock(const std::string& minerAddress) {
-    std::lock_guard<std::mutex> lock(m_chainMutex);
+BlockHeader Blockchain::getLatestHeader() const {
+    return getChainSnapshot()->back();
+}
+
+std::shared_ptr<const ChainSnapshot> Blockchain::getChainSnapshot() const {
+    return std::atomic_load(&m_chain);
+}
+
+std::shared_ptr<const Block> Blockchain::getBlock(size_t height) const {
+    if (height >= getChainSnapshot()->size()) {
+        return nullptr;
+    }
     
-    // Check if miner has enough memories to mine
-    if (!hasEnoughMemoriesForMining(minerAddress)) {
-        std::cerr << "Miner doesn't have enough memories to mine a block" << std::endl;
+    std::shared_ptr<const Block> block = m_blockCache.get(height);
+    if (!block && height >= getPrunedHeight()) {
+        std::cerr << "Failed to load block " << height << std::endl;
+    }
+    return block;
+}
+
+void Blockchain::setPruneDepth(size_t depth) {
+    m_pruneDepth = depth;
+}
+
+size_t Blockchain::getPruneDepth() const {
+    return m_pruneDepth;
+}
+
+size_t Blockchain::getPrunedHeight() const {
+    return m_blockCache.getPrunedHeight();
+}
+
+bool Blockchain::verifyTransactionProof(size_t height, const Hash256& txHash, size_t txIndex,
+                                        const std::vector<Hash256>& proof) const {
+    std::shared_ptr<const ChainSnapshot> chain = getChainSnapshot();
+    if (height >= chain->size()) {
         return false;
     }
     
-    Block latestBlock = m_chain.back();
-    Block newBlock(latestBlock.getIndex() + 1, m_pendingTransactions, latestBlock.getHash());
+    const BlockHeader& header = (*chain)[height];
+    return Block::verifyMerkleProof(txHash, txIndex, header.getTransactionCount(), proof,
+                                    header.getMerkleRoot());
+}
+
+BlockCacheStats Blockchain::getBlockCacheStats() const {
+    return m_blockCache.getStats();
+}
+
+bool Blockchain::addBlock(const std::string& minerAddress) {
+    Block newBlock;
+    if (!buildBlockTemplate(minerAddress, false, newBlock)) {
+        return false;
+    }
     
-    // Try to mine the block (performs proof of memories)
-    if (!newBlock.mineBlock(4, minerAddress)) { // Difficulty level of 4 (can be adjusted)
+    // Try to mine the block (performs proof of memories) without holding the chain lock
+    if (!mineBlockTemplate(newBlock, minerAddress)) {
         std::cerr << "Failed to mine block" << std::endl;
         return false;
     }
     
-    // Validate the new block
-    if (!isValidNewBlock(newBlock, latestBlock)) {
+    return submitBlock(newBlock);
+}
+
+bool Blockchain::createBlockTemplate(const std::string& minerAddress, Block& block) const {
+    return buildBlockTemplate(minerAddress, true, block);
+}
+
+bool Blockchain::buildBlockTemplate(const std::string& minerAddress, bool includeReward, Block& block) const {
+    std::shared_ptr<const ChainSnapshot> chain;
+    std::shared_ptr<const Mempool::Snapshot> pending;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_chainMutex);
+        
+        // Check if miner has enough memories to mine
+        if (!hasEnoughMemoriesForMining(minerAddress)) {
+            std::cerr << "Miner doesn't have enough memories to mine a block" << std::endl;
+            return false;
+        }
+        
+        // Both snapshots are O(1); taken together they agree with each other
+        chain = m_chain;
+        pending = m_mempool.snapshot();
+    }
+    
+    std::vector<Transaction> transactions = pending->toVector();
+    if (includeReward) {
+        // Mining reward transaction included in the block itself
+        transactions.emplace_back(minerAddress, m_miningReward, "mining_reward");
+    }
+    
+    const BlockHeader& latestBlock = chain->back();
+    block = Block(latestBlock.getIndex() + 1, transactions, latestBlock.getHash(),
+                  calculateTargetBits(*chain, chain->size()));
+    return true;
+}
+
+bool Blockchain::mineBlockTemplate(Block& block, const std::string& minerAddress, size_t threadCount,
+                                   const std::atomic<bool>* cancel, std::atomic<uint64_t>* progress) {
+    // Runs without the chain lock; the telemetry has its own
+    return block.mineBlock(minerAddress, threadCount, cancel, progress, &m_miningTelemetry);
+}
+
+MiningStats Blockchain::getMiningStats() const {
+    return m_miningTelemetry.getStats();
+}
+
+bool Blockchain::submitBlock(const Block& block) {
+    std::unique_lock<std::shared_mutex> lock(m_chainMutex);
+    
+    // Validate the new block against the current tip; a template mined
+    // while another block was added no longer links and is rejected here
+    if (!isValidNewBlock(*m_chain, block)) {
         std::cerr << "Invalid new block" << std::endl;
         return false;
     }
     
+    // Write the block to the store before the chain, so a block that
+    // cannot be persisted is never accepted
+    BlockStore* store = m_blockStore.get();
+    uint64_t sequence = 0;
+    if (store && !store->append(block, sequence)) {
+        std::cerr << "Failed to store new block" << std::endl;
+        return false;
+    }
+    
     // Add the block to the chain
-    m_chain.push_back(newBlock);
+    appendBlock(block);
     
-    // Clear pending transactions and create mining reward
-    m_pendingTransactions.clear();
+    // The block was validated above, so a checkpoint at the old tip moves with it
+    {
+        std::lock_guard<std::mutex> checkpointLock(m_checkpointMutex);
+        if (m_validationCheckpoint.height == block.getIndex() &&
+            m_validationCheckpoint.tipHash == block.getPreviousHash()) {
+            m_validationCheckpoint = {block.getIndex() + 1, block.getHash()};
+        }
+    }
+    
+    // Drop the pending transactions the block included; any that arrived
+    // after the template was taken stay pending
+    m_mempool.remove(block.getTransactions());
     
     // Create a reward transaction for the miner
-    Transaction rewardTx("", minerAddress, m_miningReward);
-    m_pendingTransactions.push_back(rewardTx);
+    Transaction rewardTx("", block.getMinerAddress(), m_miningReward);
+    m_mempool.addSystem(rewardTx);
+    
+    // Flush outside the lock; blocks submitted meanwhile share the flush
+    lock.unlock();
+    if (store && !store->sync(sequence)) {
+        std::cerr << "Block " << block.getIndex() << " was accepted but may not be durable" << std::endl;
+    } else if (store && (block.getIndex() + 1) % STATE_SNAPSHOT_INTERVAL == 0) {
+        scheduleStateSnapshot();
+    }
     
     return true;
 }
 
-bool Blockchain::isValidNewBlock(const Block& newBlock, const Block& previousBlock) const {
-    // Check index continuity
-    if (newBlock.getIndex() != previousBlock.getIndex() + 1) {
-        std::cerr << "Invalid block index" << std::endl;
+void Blockchain::appendBlock(const Block& block) {
+    // Callers hold m_chainMutex exclusively (or are the constructor). The
+    // body is cached before the header is published, so a reader that sees
+    // the header can find the body. Readers holding the old snapshot keep
+    // a consistent view
+    m_blockCache.insert(std::make_shared<const Block>(block));
+    std::atomic_store(&m_chain, m_chain->append(block.getHeader()));
+    applyBlockState(block);
+}
+
+void Blockchain::applyBlockState(const Block& block) {
+    const auto& transactions = block.getTransactions();
+    for (size_t i = 0; i < transactions.size(); ++i) {
+        const Transaction& tx = transactions[i];
+        applyBalanceChange(m_confirmedBalances, tx);
+        
+        TransactionLocation location{block.getIndex(), static_cast<uint32_t>(i)};
+        m_addressHistory[tx.getFromAddress()].push_back(location);
+        if (tx.getToAddress() != tx.getFromAddress()) {
+            m_addressHistory[tx.getToAddress()].push_back(location);
+        }
+    }
+}
+
+bool Blockchain::isValidNewBlock(const ChainSnapshot& chain, const Block& newBlock) const {
+    if (chain.empty()) {
         return false;
     }
     
-    // Check previous hash link
-    if (newBlock.getPreviousHash() != previousBlock.getHash()) {
-        std::cerr << "Invalid previous block hash" << std::endl;
+    BlockHeader header = newBlock.getHeader();
+    std::string error;
+    if (!checkBlockLink(header, chain.back(), error) ||
+        !checkBlockContents(chain, header, newBlock, newBlock.calculateHash(), error)) {
+        std::cerr << error << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+bool Blockchain::checkBlockContents(const ChainSnapshot& chain, const BlockHeader& header, const Block& body,
+                                    const Hash256& hash, std::string& error) const {
+    // Everything here depends only on the block and the blocks below it,
+    // so blocks can be checked in any order. hash is the block's header
+    // hash, computed by the caller so it can batch the hashing
+    
+    // Verify the header commits to the transactions in the body
+    if (body.calculateMerkleRoot() != header.getMerkleRoot()) {
+        error = "Invalid merkle root";
         return false;
     }
     
+    return checkBlockHeader(chain, header, hash, error);
+}
+
+bool Blockchain::checkBlockHeader(const ChainSnapshot& chain, const BlockHeader& header, const Hash256& hash,
+                                  std::string& error) const {
+    // The part of checkBlockContents that needs no body, which is all a
+    // pruned block can still be checked against
+    
     // Verify block hash
-    if (newBlock.calculateHash() != newBlock.getHash()) {
-        std::cerr << "Invalid block hash" << std::endl;
+    if (hash != header.getHash()) {
+        error = "Invalid block hash";
+        return false;
+    }
+    
+    // The target must be the one the retarget rule gives for this height
+    if (header.getTargetBits() != calculateTargetBits(chain, header.getIndex())) {
+        error = "Invalid block target";
+        return false;
+    }
+    
+    if (!header.hasValidProofOfWork()) {
+        error = "Block hash does not meet target";
+        return false;
+    }
+    
+    return true;
+}
+
+uint32_t Blockchain::calculateTargetBits(const ChainSnapshot& chain, size_t height) const {
+    // The chain must contain every block below height
+    if (height <= RETARGET_WINDOW || height > chain.size()) {
+        return Block::DEFAULT_TARGET_BITS;
+    }
+    
+    std::vector<Hash256> targets;
+    targets.reserve(RETARGET_WINDOW);
+    for (size_t i = height - RETARGET_WINDOW; i < height; ++i) {
+        targets.push_back(chain[i].getTarget());
+    }
+    
+    // Time taken by the window, measured between the blocks that bound it,
+    // clamped so one window cannot swing the target more than the limit
+    const int64_t expectedSpan = static_cast<int64_t>(RETARGET_WINDOW) * TARGET_BLOCK_INTERVAL;
+    int64_t actualSpan = static_cast<int64_t>(chain[height - 1].getTimestamp()) -
+                         static_cast<int64_t>(chain[height - 1 - RETARGET_WINDOW].getTimestamp());
+    actualSpan = std::max<int64_t>(actualSpan, expectedSpan / MAX_ADJUSTMENT_FACTOR);
+    actualSpan = std::min<int64_t>(actualSpan, expectedSpan * MAX_ADJUSTMENT_FACTOR);
+    
+    Hash256 target = ahmiyat::utils::scaleTarget(ahmiyat::utils::averageTargets(targets),
+                                                 static_cast<uint32_t>(actualSpan),
+                                                 static_cast<uint32_t>(expectedSpan));
+    
+    Hash256 maxTarget;
+    ahmiyat::utils::compactToTarget(MAX_TARGET_BITS, maxTarget);
+    if (maxTarget < target) {
+        target = maxTarget;
+    }
+    if (target.isZero()) {
+        return chain[height - 1].getTargetBits();
+    }
+    
+    return ahmiyat::utils::targetToCompact(target);
+}
+
+uint32_t Blockchain::getNextTargetBits() const {
+    std::shared_ptr<const ChainSnapshot> chain = getChainSnapshot();
+    return calculateTargetBits(*chain, chain->size());
+}
+
+bool Blockchain::checkBlockLink(const BlockHeader& newBlock, const BlockHeader& previousBlock,
+                                std::string& error) const {
+    // Check index continuity
+    if (newBlock.getIndex() != previousBlock.getIndex() + 1) {
+        error = "Invalid block index";
+        return false;
+    }
+    
+    // Check previous hash link
+    if (newBlock.getPreviousHash() != previousBlock.getHash()) {
+        error = "Invalid previous block hash";
         return false;
     }
     
@@ -93,24 +372,174 @@ bool Blockchain::hasEnoughMemoriesForMining(const std::string& address) const {
 }
 
 std::vector<Block> Blockchain::getChain() const {
-    std::lock_guard<std::mutex> lock(m_chainMutex);
-    return m_chain;
+    std::shared_ptr<const ChainSnapshot> chain = getChainSnapshot();
+    size_t prunedHeight = std::min(getPrunedHeight(), chain->size());
+    
+    std::vector<Block> blocks;
+    blocks.reserve(chain->size() - prunedHeight);
+    for (size_t i = prunedHeight; i < chain->size(); ++i) {
+        std::shared_ptr<const Block> block = m_blockCache.read(i);
+        if (!block) {
+            std::cerr << "Failed to load block " << i << std::endl;
+            break;
+        }
+        blocks.push_back(*block);
+    }
+    
+    return blocks;
 }
 
 bool Blockchain::isChainValid() const {
-    std::lock_guard<std::mutex> lock(m_chainMutex);
+    return validateChain().valid;
+}
+
+ChainValidationResult Blockchain::validateChain(ValidationMode mode) const {
+    // Validate a snapshot; blocks appended meanwhile are checked on submission
+    std::shared_ptr<const ChainSnapshot> snapshot = getChainSnapshot();
+    const ChainSnapshot& chain = *snapshot;
     
-    // Start from index 1 since we can't validate the genesis block
-    for (size_t i = 1; i < m_chain.size(); ++i) {
-        const Block& currentBlock = m_chain[i];
-        const Block& previousBlock = m_chain[i - 1];
+    // Start from index 1 since we can't validate the genesis block, or just
+    // above the checkpoint if it still describes this chain
+    size_t first = 1;
+    if (mode == ValidationMode::INCREMENTAL) {
+        ValidationCheckpoint checkpoint = getValidationCheckpoint();
+        if (checkpoint.height > first && checkpoint.height <= chain.size() &&
+            chain[checkpoint.height - 1].getHash() == checkpoint.tipHash) {
+            first = checkpoint.height;
+        }
+    }
+    
+    ChainValidationResult result;
+    result.fromHeight = first;
+    if (first >= chain.size()) {
+        return result;
+    }
+    
+    // Block contents are independent of each other, so chunks are checked
+    // in parallel; each chunk stops at its first invalid block and records it
+    const size_t chunkCount = (chain.size() - first + VALIDATION_CHUNK_SIZE - 1) / VALIDATION_CHUNK_SIZE;
+    std::vector<std::string> chunkErrors(chunkCount);
+    std::atomic<size_t> firstInvalid(chain.size());
+    
+    ahmiyat::utils::ThreadPool::shared().parallelFor(chunkCount, [&](size_t chunk) {
+        size_t start = first + chunk * VALIDATION_CHUNK_SIZE;
+        size_t end = std::min(start + VALIDATION_CHUNK_SIZE, chain.size());
         
-        // Validate the block
-        if (!isValidNewBlock(currentBlock, previousBlock)) {
-            return false;
+        // A lower chunk already failed, so nothing here can be the first
+        if (start >= firstInvalid.load()) {
+            return;
+        }
+        
+        // Re-hash the chunk's headers in a batch across SIMD lanes
+        std::vector<std::string> preimages;
+        preimages.reserve(end - start);
+        for (size_t i = start; i < end; ++i) {
+            preimages.push_back(chain[i].hashPreimage());
+        }
+        std::vector<Hash256> hashes = ahmiyat::utils::sha256Batch(preimages);
+        
+        for (size_t i = start; i < end; ++i) {
+            // Bodies are read past the cache, so a full audit does not evict
+            // the blocks queries are using
+            std::shared_ptr<const Block> body = m_blockCache.read(i);
+            bool valid;
+            if (body) {
+                valid = checkBlockContents(chain, chain[i], *body, hashes[i - start], chunkErrors[chunk]);
+            } else if (i < getPrunedHeight()) {
+                // Pruned after it was validated; only the header is left
+                // to check. Asked here, since pruning can run meanwhile
+                valid = checkBlockHeader(chain, chain[i], hashes[i - start], chunkErrors[chunk]);
+            } else {
+                valid = false;
+                chunkErrors[chunk] = "Block body unreadable";
+            }
+            if (!valid) {
+                size_t lowest = firstInvalid.load();
+                while (i < lowest && !firstInvalid.compare_exchange_weak(lowest, i)) {
+                }
+                return;
+            }
+        }
+    });
+    
+    // Links need neighbouring blocks but are cheap comparisons; check them
+    // in order below the lowest block that failed its contents
+    size_t invalidHeight = firstInvalid.load();
+    std::string error;
+    for (size_t i = first; i < invalidHeight; ++i) {
+        if (!checkBlockLink(chain[i], chain[i - 1], error)) {
+            invalidHeight = i;
+            break;
+        }
+    }
+    
+    // Everything below invalidHeight is now known to be valid. A failure
+    // replaces the checkpoint even if that lowers it
+    {
+        std::lock_guard<std::mutex> lock(m_checkpointMutex);
+        if (invalidHeight < chain.size() || invalidHeight > m_validationCheckpoint.height) {
+            m_validationCheckpoint = {invalidHeight, chain[invalidHeight - 1].getHash()};
         }
     }
     
+    if (invalidHeight == chain.size()) {
+        result.blocksChecked = chain.size() - first;
+        return result;
+    }
+    
+    if (error.empty()) {
+        error = chunkErrors[(invalidHeight - first) / VALIDATION_CHUNK_SIZE];
+    }
+    
+    result.valid = false;
+    result.invalidHeight = invalidHeight;
+    result.error = error;
+    result.blocksChecked = invalidHeight - first;
+    std::cerr << "Invalid block at height " << invalidHeight << ": " << error << std::endl;
+    return result;
+}
+
+ValidationCheckpoint Blockchain::getValidationCheckpoint() const {
+    std::lock_guard<std::mutex> lock(m_checkpointMutex);
+    return m_validationCheckpoint;
+}
+
+bool Blockchain::saveValidationCheckpoint(const std::string& filename) const {
+    ValidationCheckpoint checkpoint = getValidationCheckpoint();
+    
+    std::stringstream ss;
+    ss << checkpoint.height << " " << checkpoint.tipHash.toHex() << "\n";
+    
+    // Write beside the old file and rename over it, so a crash leaves one
+    // or the other rather than a torn checkpoint
+    std::string tempFilename = filename + ".tmp";
+    if (!ahmiyat::utils::writeToFile(tempFilename, ss.str()) ||
+        std::rename(tempFilename.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Failed to save validation checkpoint" << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+bool Blockchain::loadValidationCheckpoint(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open validation checkpoint file" << std::endl;
+        return false;
+    }
+    
+    // Only trusted by validateChain if the loaded chain still has the tip
+    ValidationCheckpoint checkpoint;
+    std::string tipHash;
+    if (!(file >> checkpoint.height >> tipHash) || checkpoint.height == 0 ||
+        !Hash256::tryFromHex(tipHash, checkpoint.tipHash)) {
+        std::cerr << "Invalid validation checkpoint file" << std::endl;
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_checkpointMutex);
+    m_validationCheckpoint = checkpoint;
     return true;
 }
 
@@ -121,40 +550,44 @@ bool Blockchain::addTransaction(const Transaction& transaction) {
         return false;
     }
     
-    // For non-reward transactions, check if sender has enough balance
-    if (transaction.getType() == Transaction::TransactionType::COIN_TRANSFER) {
-        if (getBalance(transaction.getFromAddress()) < transaction.getAmount()) {
+    // A shared lock keeps confirmed balances fixed while the mempool checks
+    // the sender's balance; transactions from different senders go in
+    // concurrently
+    std::shared_lock<std::shared_mutex> lock(m_chainMutex);
+    
+    // For non-reward transactions the mempool checks and reserves the
+    // sender's balance
+    switch (m_mempool.add(transaction, getConfirmedBalance(transaction.getFromAddress()))) {
+        case MempoolAddResult::ADDED:
+            return true;
+        case MempoolAddResult::DUPLICATE:
+            std::cerr << "Transaction is already pending" << std::endl;
+            return false;
+        case MempoolAddResult::INSUFFICIENT_BALANCE:
             std::cerr << "Not enough balance for transaction" << std::endl;
             return false;
-        }
     }
     
-    // Add to pending transactions
-    m_pendingTransactions.push_back(transaction);
-    return true;
+    return false;
 }
 
 std::vector<Transaction> Blockchain::getPendingTransactions() const {
-    return m_pendingTransactions;
+    return m_mempool.snapshot()->toVector();
 }
 
 bool Blockchain::processTransaction(const Transaction& transaction) {
     // For memory reward transactions, verify the memory proof
     if (transaction.getType() == Transaction::TransactionType::MEMORY_REWARD) {
         // Find the memory proof by hash
-        bool foundMemoryProof = false;
+        Hash256 proofHash;
         
-        for (const auto& entry : m_memoryProofs) {
-            for (const auto& proof : entry.second) {
-                if (proof.getProofHash() == transaction.getMemoryProofHash()) {
-                    foundMemoryProof = true;
-                    break;
-                }
-            }
-            if (foundMemoryProof) break;
+        if (!Hash256::tryFromHex(transaction.getMemoryProofHash(), proofHash)) {
+            std::cerr << "Memory proof not found for reward transaction" << std::endl;
+            return false;
         }
         
-        if (!foundMemoryProof) {
+        std::shared_lock<std::shared_mutex> lock(m_chainMutex);
+        if (!findMemoryProof(proofHash)) {
             std::cerr << "Memory proof not found for reward transaction" << std::endl;
             return false;
         }
@@ -164,33 +597,78 @@ bool Blockchain::processTransaction(const Transaction& transaction) {
 }
 
 double Blockchain::getBalance(const std::string& address) const {
-    double balance = 0.0;
+    std::shared_lock<std::shared_mutex> lock(m_chainMutex);
+    return calculateBalance(address);
+}
+
+double Blockchain::calculateBalance(const std::string& address) const {
+    // Callers hold m_chainMutex; confirmed balance from the chain plus the
+    // pending transactions
+    return getConfirmedBalance(address) + m_mempool.getPendingDelta(address);
+}
+
+double Blockchain::getConfirmedBalance(const std::string& address) const {
+    // Callers hold m_chainMutex
+    auto confirmed = m_confirmedBalances.find(address);
+    return confirmed != m_confirmedBalances.end() ? confirmed->second : 0.0;
+}
+
+TransactionPage Blockchain::getTransactionsForAddress(const std::string& address, size_t cursor,
+                                                     size_t limit) const {
+    TransactionPage page;
+    size_t begin = 0;
+    size_t end = 0;
     
-    // Check all blocks for transactions involving this address
-    for (const auto& block : m_chain) {
-        for (const auto& tx : block.getTransactions()) {
-            if (tx.getFromAddress() == address) {
-                balance -= tx.getAmount();
-            }
-            
-            if (tx.getToAddress() == address) {
-                balance += tx.getAmount();
-            }
-        }
-    }
+    // A zero limit would hand back the same cursor forever
+    limit = std::max<size_t>(limit, 1);
     
-    // Also check pending transactions
-    for (const auto& tx : m_pendingTransactions) {
-        if (tx.getFromAddress() == address) {
-            balance -= tx.getAmount();
+    {
+        std::shared_lock<std::shared_mutex> lock(m_chainMutex);
+        auto it = m_addressHistory.find(address);
+        if (it == m_addressHistory.end()) {
+            return page;
         }
         
-        if (tx.getToAddress() == address) {
-            balance += tx.getAmount();
+        // The cursor is an exclusive end position in the history; history only
+        // grows at the back, so positions below it never shift
+        const std::vector<TransactionLocation>& history = it->second;
+        page.total = history.size();
+        end = (cursor == 0 || cursor > history.size()) ? history.size() : cursor;
+        begin = end - std::min(end, limit);
+        
+        page.locations.assign(history.rbegin() + (history.size() - end),
+                              history.rbegin() + (history.size() - begin));
+    }
+    
+    // Every location is in a block already appended; copy the transactions
+    // out of their bodies without holding the lock. Newest
+    // first, so neighbouring locations usually share a block
+    page.transactions.reserve(page.locations.size());
+    std::shared_ptr<const Block> block;
+    for (const TransactionLocation& location : page.locations) {
+        if (!block || block->getIndex() != location.blockIndex) {
+            block = getBlock(location.blockIndex);
+            if (!block) {
+                page.locations.resize(page.transactions.size());
+                
+                // Everything older is pruned too, so the history ends here;
+                // otherwise the read failed, and the next page starts at the
+                // transaction that could not be read rather than skipping it
+                if (location.blockIndex < getPrunedHeight()) {
+                    begin = 0;
+                } else {
+                    page.incomplete = true;
+                    begin = end - page.transactions.size();
+                }
+                break;
+            }
         }
+        page.transactions.push_back(block->getTransactions()[location.txOffset]);
     }
     
-    return balance;
+    page.hasMore = begin > 0;
+    page.nextCursor = page.hasMore ? begin : 0;
+    return page;
 }
 
 bool Blockchain::verifyMemoryProof(const MemoryProof& proof) {
@@ -200,47 +678,87 @@ bool Blockchain::verifyMemoryProof(const MemoryProof& proof) {
     }
     
     // Check if this memory already exists (prevent duplicates)
-    for (const auto& entry : m_memoryProofs) {
-        for (const auto& existingProof : entry.second) {
-            if (existingProof.getFileHash() == proof.getFileHash()) {
-                std::cerr << "Memory already exists in the blockchain" << std::endl;
-                return false;
-            }
-        }
+    std::shared_lock<std::shared_mutex> lock(m_chainMutex);
+    if (isKnownMemory(proof.getContentKey())) {
+        std::cerr << "Memory already exists in the blockchain" << std::endl;
+        return false;
     }
     
     return true;
 }
 
+bool Blockchain::isKnownMemory(const Hash256& contentKey) const {
+    // Callers hold m_chainMutex
+    return m_memoryProofsByContentKey.count(contentKey) > 0;
+}
+
+const MemoryProof* Blockchain::findMemoryProof(const Hash256& proofHash) const {
+    // Callers hold m_chainMutex
+    auto it = m_memoryProofsByHash.find(proofHash);
+    if (it == m_memoryProofsByHash.end()) {
+        return nullptr;
+    }
+    
+    return &m_memoryProofs.at(it->second.uploader)[it->second.position];
+}
+
+void Blockchain::indexMemoryProof(const MemoryProof& proof, const Hash256& proofHash) {
+    // Callers hold m_chainMutex exclusively
+    std::string uploader = proof.getUploader();
+    std::vector<MemoryProof>& uploaderProofs = m_memoryProofs[uploader];
+    MemoryProofRef ref{uploader, uploaderProofs.size()};
+    uploaderProofs.push_back(proof);
+    m_memoryProofsByHash.emplace(proofHash, ref);
+    m_memoryProofsByContentKey.emplace(proof.getContentKey(), ref);
+}
+
 bool Blockchain::storeMemoryProof(const MemoryProof& proof) {
-    if (!verifyMemoryProof(proof)) {
+    if (!proof.isValid()) {
+        std::cerr << "Invalid memory proof signature" << std::endl;
         return false;
     }
     
-    // Store the proof
-    std::string uploader = proof.getUploader();
-    m_memoryProofs[uploader].push_back(proof);
+    std::unique_lock<std::shared_mutex> lock(m_chainMutex);
+    
+    // Check and insert under one lock so concurrent uploads cannot both pass
+    if (isKnownMemory(proof.getContentKey())) {
+        std::cerr << "Memory already exists in the blockchain" << std::endl;
+        return false;
+    }
+    
+    // The proof is durable before it is indexed, so a crash cannot forget
+    // a memory whose reward may already be in a block; the proof hash is
+    // computed once here
+    Hash256 proofHash = proof.getProofHash();
+    if (m_blockStore && !m_blockStore->appendMemoryProofs({proof}, {proofHash})) {
+        std::cerr << "Failed to store memory proof" << std::endl;
+        return false;
+    }
+    indexMemoryProof(proof, proofHash);
     
     // Create a reward transaction for the uploader
     // The reward amount could depend on memory type, size, etc.
     double reward = 10.0; // Fixed reward for simplicity
     
-    Transaction rewardTx(uploader, reward, proof.getProofHash());
-    m_pendingTransactions.push_back(rewardTx);
+    Transaction rewardTx(proof.getUploader(), reward, proofHash.toHex());
+    m_mempool.addSystem(rewardTx);
     
     return true;
 }
 
 void Blockchain::minePendingTransactions(const std::string& minerAddress) {
-    // Add a mining reward transaction (will be included in the next block)
-    Transaction rewardTx(minerAddress, m_miningReward, "mining_reward");
-    m_pendingTransactions.push_back(rewardTx);
+    // The template carries a mining reward transaction for this block
+    Block newBlock;
+    if (!createBlockTemplate(minerAddress, newBlock)) {
+        return;
+    }
     
-    // Try to add a new block containing pending transactions
-    if (!addBlock(minerAddress)) {
-        // If mining fails, remove the reward transaction
-        m_pendingTransactions.pop_back();
+    if (!mineBlockTemplate(newBlock, minerAddress)) {
+        std::cerr << "Failed to mine block" << std::endl;
+        return;
     }
+    
+    submitBlock(newBlock);
 }
 
 double Blockchain::getMiningReward() const {
@@ -252,20 +770,36 @@ void Blockchain::setMiningReward(double reward) {
 }
 
 size_t Blockchain::getChainSize() const {
-    std::lock_guard<std::mutex> lock(m_chainMutex);
-    return m_chain.size();
+    return getChainSnapshot()->size();
 }
 
 std::string Blockchain::getChainAsJson() const {
-    std::lock_guard<std::mutex> lock(m_chainMutex);
+    // Take both parts under the lock so they agree, then serialize without it
+    std::shared_ptr<const ChainSnapshot> chain;
+    std::shared_ptr<const Mempool::Snapshot> pending;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_chainMutex);
+        chain = m_chain;
+        pending = m_mempool.snapshot();
+    }
+    const Mempool::Snapshot& pendingTransactions = *pending;
+    size_t prunedHeight = std::min(getPrunedHeight(), chain->size());
     
     std::stringstream ss;
     ss << "{\n";
+    ss << "  \"prunedHeight\": " << prunedHeight << ",\n";
     ss << "  \"chain\": [\n";
     
-    for (size_t i = 0; i < m_chain.size(); ++i) {
-        ss << m_chain[i].toJson();
-        if (i < m_chain.size() - 1) {
+    // Pruned blocks have no body to show
+    for (size_t i = prunedHeight; i < chain->size(); ++i) {
+        // A one-off walk over every body; read past the cache
+        std::shared_ptr<const Block> block = m_blockCache.read(i);
+        if (!block) {
+            std::cerr << "Failed to load block " << i << std::endl;
+            break;
+        }
+        ss << block->toJson();
+        if (i < chain->size() - 1) {
             ss << ",";
         }
         ss << "\n";
@@ -274,9 +808,9 @@ std::string Blockchain::getChainAsJson() const {
     ss << "  ],\n";
     ss << "  \"pendingTransactions\": [\n";
     
-    for (size_t i = 0; i < m_pendingTransactions.size(); ++i) {
-        ss << m_pendingTransactions[i].toJson();
-        if (i < m_pendingTransactions.size() - 1) {
+    for (size_t i = 0; i < pendingTransactions.size(); ++i) {
+        ss << pendingTransactions[i].toJson();
+        if (i < pendingTransactions.size() - 1) {
             ss << ",";
         }
         ss << "\n";
@@ -288,28 +822,328 @@ std::string Blockchain::getChainAsJson() const {
     return ss.str();
 }
 
-void Blockchain::saveChain(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file for saving blockchain");
+bool Blockchain::saveChain(const std::string& directory) {
+    std::unique_lock<std::shared_mutex> lock(m_chainMutex);
+    
+    // Already attached: every block is in the store, so just flush it
+    if (m_blockStore) {
+        if (m_blockStore->getDirectory() != directory) {
+            std::cerr << "Blockchain is already stored in " << m_blockStore->getDirectory() << std::endl;
+            return false;
+        }
+        lock.unlock();
+        return m_blockStore->syncAll() && saveValidationCheckpoint(checkpointPath(directory)) &&
+               saveStateSnapshot();
+    }
+    
+    auto store = std::make_shared<BlockStore>(directory);
+    std::vector<BlockHeader> headers;
+    if (!store->open(headers)) {
+        return false;
+    }
+    if (!headers.empty()) {
+        std::cerr << "Block store already holds a chain; load it instead" << std::endl;
+        return false;
+    }
+    if (!writeChain(*store)) {
+        return false;
     }
     
-    file << getChainAsJson();
-    file.close();
+    attachBlockStore(std::move(store));
+    lock.unlock();
+    return saveValidationCheckpoint(checkpointPath(directory)) && saveStateSnapshot();
 }
 
-bool Blockchain::loadChain(const std::string& filename) {
-    // Implementation would deserialize the blockchain from JSON
-    // This is a simplified version - would need full JSON parsing
+bool Blockchain::loadChain(const std::string& directory) {
+    // Reading the store and the state snapshot is the slow part; do it
+    // before taking the lock
+    auto store = std::make_shared<BlockStore>(directory);
+    std::vector<BlockHeader> headers;
+    if (!store->open(headers)) {
+        return false;
+    }
+    StateSnapshot state;
+    bool haveState = !headers.empty() && std::filesystem::exists(statePath(directory)) &&
+                     StateSnapshot::load(statePath(directory), state);
+    std::vector<MemoryProof> loggedProofs;
+    std::vector<Hash256> loggedProofHashes;
+    if (!store->loadMemoryProofs(loggedProofs, loggedProofHashes)) {
+        return false;
+    }
     
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open blockchain file for loading" << std::endl;
+    std::unique_lock<std::shared_mutex> lock(m_chainMutex);
+    if (m_blockStore) {
+        std::cerr << "Blockchain is already stored in " << m_blockStore->getDirectory() << std::endl;
         return false;
     }
     
-    // In a real implementation, we would parse the JSON and reconstruct the chain
-    // For this example, we'll just say it's not implemented
-    std::cerr << "Blockchain loading not fully implemented" << std::endl;
-    return false;
+    if (headers.empty()) {
+        // A new store starts out holding the chain so far
+        if (!writeChain(*store)) {
+            return false;
+        }
+    } else {
+        // The stored chain has its own genesis block, so it can only
+        // replace a chain nothing has been added to yet
+        if (m_chain->size() > 1 || m_mempool.size() > 0) {
+            std::cerr << "Cannot load a stored chain over one that already has blocks" << std::endl;
+            return false;
+        }
+        
+        // Replacing the chain needs the cache and checkpoint in place to
+        // validate it, so a failure puts back the fresh chain instead
+        std::shared_ptr<const Block> genesis = m_blockCache.read(0);
+        if (!replaceChain(store, headers, haveState ? &state : nullptr)) {
+            restoreGenesis(genesis);
+            return false;
+        }
+        
+        // Memory proofs are not in blocks, so they are restored even if
+        // the rest of the snapshot no longer matches the chain
+        if (haveState) {
+            restoreMemoryProofs(state);
+        }
+    }
+    
+    // The log holds every proof stored since the store was created,
+    // including those newer than the snapshot
+    for (size_t i = 0; i < loggedProofs.size(); ++i) {
+        if (!m_memoryProofsByHash.count(loggedProofHashes[i]) && !isKnownMemory(loggedProofs[i].getContentKey())) {
+            indexMemoryProof(loggedProofs[i], loggedProofHashes[i]);
+        }
+    }
+    
+    attachBlockStore(std::move(store));
+    lock.unlock();
+    return saveValidationCheckpoint(checkpointPath(directory));
+}
+
+bool Blockchain::replaceChain(const std::shared_ptr<BlockStore>& store, std::vector<BlockHeader>& headers,
+                              const StateSnapshot* state) {
+    // Callers hold m_chainMutex exclusively. Only headers are loaded; from
+    // here on bodies are read from the store, including those replayed and
+    // validated below
+    m_blockCache.truncate(0);
+    m_blockCache.setSource(store);
+    if (!resetChain(headers, state && stateCoversChain(*state, headers) ? state : nullptr)) {
+        return false;
+    }
+    
+    // Blocks covered by the saved checkpoint were validated before they
+    // were stored; validate the rest
+    {
+        std::lock_guard<std::mutex> checkpointLock(m_checkpointMutex);
+        m_validationCheckpoint = {1, headers.front().getHash()};
+    }
+    std::string checkpointFile = checkpointPath(store->getDirectory());
+    if (std::filesystem::exists(checkpointFile)) {
+        loadValidationCheckpoint(checkpointFile);
+    }
+    
+    ChainValidationResult validation = validateChain();
+    if (!validation.valid) {
+        std::cerr << "Discarding stored blocks from height " << validation.invalidHeight << std::endl;
+        headers.resize(validation.invalidHeight);
+        if (!resetChain(headers, state && stateCoversChain(*state, headers) ? state : nullptr) ||
+            !store->truncate(validation.invalidHeight)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+void Blockchain::restoreGenesis(const std::shared_ptr<const Block>& genesis) {
+    // Callers hold m_chainMutex exclusively. Undoes a partial replaceChain:
+    // back to the genesis block alone, with every body held in the cache
+    m_blockCache.truncate(0);
+    m_blockCache.setSource(nullptr);
+    m_confirmedBalances.clear();
+    m_addressHistory.clear();
+    std::atomic_store(&m_chain, std::make_shared<const ChainSnapshot>());
+    appendBlock(*genesis);
+    
+    std::lock_guard<std::mutex> checkpointLock(m_checkpointMutex);
+    m_validationCheckpoint = {1, genesis->getHash()};
+}
+
+bool Blockchain::resetChain(const std::vector<BlockHeader>& headers, const StateSnapshot* state) {
+    // Callers hold m_chainMutex exclusively. Rebuilds the chain and the
+    // state derived from it, replaying only the blocks above the snapshot
+    std::atomic_store(&m_chain, std::make_shared<const ChainSnapshot>(headers));
+    
+    size_t replayFrom = 0;
+    if (state) {
+        m_confirmedBalances = state->balances;
+        m_addressHistory = state->addressHistory;
+        replayFrom = state->height;
+    } else {
+        m_confirmedBalances.clear();
+        m_addressHistory.clear();
+    }
+    
+    // Pruning keeps a snapshot at or above the pruned height; without one
+    // the pruned blocks' effect on the state is lost
+    size_t prunedHeight = m_blockCache.getPrunedHeight();
+    if (replayFrom < prunedHeight) {
+        std::cerr << "Block store is pruned below height " << prunedHeight
+                  << " and no state snapshot covers it" << std::endl;
+        return false;
+    }
+    
+    for (size_t i = replayFrom; i < headers.size(); ++i) {
+        std::shared_ptr<const Block> block = m_blockCache.read(i);
+        if (!block) {
+            std::cerr << "Failed to load block " << i << " for replay" << std::endl;
+            return false;
+        }
+        applyBlockState(*block);
+    }
+    
+    return true;
+}
+
+void Blockchain::restoreMemoryProofs(const StateSnapshot& state) {
+    // The snapshot carries each proof's hash, so the indexes are rebuilt
+    // without re-hashing
+    m_memoryProofs = state.memoryProofs;
+    m_memoryProofsByHash.clear();
+    m_memoryProofsByContentKey.clear();
+    for (const auto& entry : m_memoryProofs) {
+        const std::vector<Hash256>& hashes = state.memoryProofHashes.at(entry.first);
+        for (size_t i = 0; i < entry.second.size(); ++i) {
+            MemoryProofRef ref{entry.first, i};
+            m_memoryProofsByHash.emplace(hashes[i], ref);
+            m_memoryProofsByContentKey.emplace(entry.second[i].getContentKey(), ref);
+        }
+    }
+}
+
+bool Blockchain::writeChain(BlockStore& store) const {
+    // Memory proofs stored before the store was attached go in its log,
+    // each uploader's in upload order
+    std::unordered_map<std::string, std::vector<Hash256>> hashesByUploader;
+    for (const auto& entry : m_memoryProofs) {
+        hashesByUploader[entry.first].resize(entry.second.size());
+    }
+    for (const auto& entry : m_memoryProofsByHash) {
+        hashesByUploader[entry.second.uploader][entry.second.position] = entry.first;
+    }
+    std::vector<MemoryProof> proofs;
+    std::vector<Hash256> hashes;
+    for (const auto& entry : m_memoryProofs) {
+        proofs.insert(proofs.end(), entry.second.begin(), entry.second.end());
+        hashes.insert(hashes.end(), hashesByUploader[entry.first].begin(), hashesByUploader[entry.first].end());
+    }
+    if (!store.appendMemoryProofs(proofs, hashes)) {
+        return false;
+    }
+    
+    // No store is attached yet, so every body is cached
+    uint64_t sequence = 0;
+    for (size_t i = 0; i < m_chain->size(); ++i) {
+        std::shared_ptr<const Block> block = m_blockCache.read(i);
+        if (!block || !store.append(*block, sequence)) {
+            return false;
+        }
+    }
+    
+    return store.sync(sequence);
+}
+
+void Blockchain::attachBlockStore(std::shared_ptr<BlockStore> store) {
+    // Callers hold m_chainMutex exclusively. Every body is in the store now,
+    // so the cache may start evicting
+    m_blockCache.setSource(store);
+    m_blockStore = std::move(store);
+    m_stateSnapshotWriter = std::make_unique<ahmiyat::utils::ThreadPool>(1);
+}
+
+void Blockchain::captureState(StateSnapshot& state) const {
+    // Callers hold m_chainMutex, so the state matches the chain's tip
+    state.height = m_chain->size();
+    state.tipHash = m_chain->back().getHash();
+    state.balances = m_confirmedBalances;
+    state.addressHistory = m_addressHistory;
+    state.memoryProofs = m_memoryProofs;
+    for (const auto& entry : m_memoryProofs) {
+        state.memoryProofHashes[entry.first].resize(entry.second.size());
+    }
+    for (const auto& entry : m_memoryProofsByHash) {
+        state.memoryProofHashes[entry.second.uploader][entry.second.position] = entry.first;
+    }
+}
+
+size_t Blockchain::pruneHeight() const {
+    // Callers hold m_chainMutex. Bodies below the returned height may go
+    // once a snapshot of the current state is on disk; 0 keeps them all
+    size_t depth = m_pruneDepth;
+    size_t size = m_chain->size();
+    return depth != NO_PRUNING && size > depth ? size - depth : 0;
+}
+
+bool Blockchain::pruneBlockBodies(size_t height) {
+    // Runs after the state snapshot covering height is on disk. Cached
+    // copies of the pruned bodies go too, so getBlock answers the same
+    // for every pruned height
+    if (!m_blockStore->prune(height)) {
+        return false;
+    }
+    m_blockCache.prune(m_blockStore->getPrunedHeight());
+    return true;
+}
+
+void Blockchain::scheduleStateSnapshot() {
+    std::lock_guard<std::mutex> lock(m_stateSnapshotMutex);
+    
+    // Still writing the previous one; the next interval catches up
+    if (m_pendingStateSnapshot.valid() &&
+        m_pendingStateSnapshot.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    
+    // Copy the state under a shared lock, which only holds off block
+    // submission; serializing and flushing happen on the writer thread
+    auto state = std::make_shared<StateSnapshot>();
+    std::string filename;
+    size_t pruneTo;
+    {
+        std::shared_lock<std::shared_mutex> chainLock(m_chainMutex);
+        captureState(*state);
+        filename = statePath(m_blockStore->getDirectory());
+        pruneTo = pruneHeight();
+    }
+    
+    // The snapshot may include blocks another submitter has appended but
+    // not yet flushed; those are flushed first, so a snapshot on disk never
+    // runs ahead of the store it is replayed against. Pruning waits for the
+    // snapshot that covers the bodies it discards. The writer thread is
+    // joined before the chain goes away
+    m_pendingStateSnapshot = m_stateSnapshotWriter->submit([this, state, filename, pruneTo]() {
+        return m_blockStore->syncAll() && state->save(filename) &&
+               (pruneTo == 0 || pruneBlockBodies(pruneTo));
+    });
+}
+
+bool Blockchain::saveStateSnapshot() {
+    std::lock_guard<std::mutex> lock(m_stateSnapshotMutex);
+    
+    // Let a background write finish first so this one lands last
+    if (m_pendingStateSnapshot.valid()) {
+        m_pendingStateSnapshot.get();
+    }
+    
+    StateSnapshot state;
+    std::string filename;
+    size_t pruneTo;
+    {
+        std::shared_lock<std::shared_mutex> chainLock(m_chainMutex);
+        if (!m_blockStore) {
+            return false;
+        }
+        captureState(state);
+        filename = statePath(m_blockStore->getDirectory());
+        pruneTo = pruneHeight();
+    }
+    return m_blockStore->syncAll() && state.save(filename) && (pruneTo == 0 || pruneBlockBodies(pruneTo));
 }
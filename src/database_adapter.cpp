@@ -326,18 +326,20 @@ PGresult* DatabaseAdapter::executeQueryWithResult(const std::string& query) {
 bool DatabaseAdapter::saveBlock(const Block& block) {
     // Prepare query
     std::stringstream query;
-    query << "INSERT INTO blocks (hash, previous_hash, timestamp, nonce, difficulty, merkle_root, height) VALUES ('"
-          << escapeString(block.getHash()) << "', '"
-          << escapeString(block.getPreviousHash()) << "', "
+    query << "INSERT INTO blocks (hash, previous_hash, timestamp, nonce, extra_nonce, difficulty, merkle_root, height) VALUES ('"
+          << escapeString(block.getHash().toHex()) << "', '"
+          << escapeString(block.getPreviousHash().toHex()) << "', "
           << block.getTimestamp() << ", "
           << block.getNonce() << ", "
+          << block.getExtraNonce() << ", "
           << block.getDifficulty() << ", '"
-          << escapeString(block.getMerkleRoot()) << "', "
+          << escapeString(block.getMerkleRoot().toHex()) << "', "
           << block.getHeight() << ") "
           << "ON CONFLICT (hash) DO UPDATE SET "
           << "previous_hash = EXCLUDED.previous_hash, "
           << "timestamp = EXCLUDED.timestamp, "
           << "nonce = EXCLUDED.nonce, "
+          << "extra_nonce = EXCLUDED.extra_nonce, "
           << "difficulty = EXCLUDED.difficulty, "
           << "merkle_root = EXCLUDED.merkle_root, "
           << "height = EXCLUDED.height";
@@ -350,7 +352,7 @@ bool DatabaseAdapter::saveBlock(const Block& block) {
 bool DatabaseAdapter::getBlock(const std::string& hash, Block& block) {
     // Prepare query
     std::stringstream query;
-    query << "SELECT hash, previous_hash, timestamp, nonce, difficulty, merkle_root, height FROM blocks WHERE hash = '"
+    query << "SELECT hash, previous_hash, timestamp, nonce, extra_nonce, difficulty, merkle_root, height FROM blocks WHERE hash = '"
           << escapeString(hash) << "' LIMIT 1";
     
     // Execute the query
@@ -370,15 +372,19 @@ bool DatabaseAdapter::getBlock(const std::string& hash, Block& block) {
     std::string previousHash = PQgetvalue(res, 0, 1);
     uint64_t timestamp = std::stoull(PQgetvalue(res, 0, 2));
     uint32_t nonce = std::stoul(PQgetvalue(res, 0, 3));
-    uint32_t difficulty = std::stoul(PQgetvalue(res, 0, 4));
-    std::string merkleRoot = PQgetvalue(res, 0, 5);
-    uint32_t height = std::stoul(PQgetvalue(res, 0, 6));
+    uint32_t extraNonce = std::stoul(PQgetvalue(res, 0, 4));
+    uint32_t difficulty = std::stoul(PQgetvalue(res, 0, 5));
+    std::string merkleRoot = PQgetvalue(res, 0, 6);
+    uint32_t height = std::stoul(PQgetvalue(res, 0, 7));
     
     // Create block
-    block = Block(previousHash, timestamp, difficulty);
-    block.setHash(dbHash);
+    block = Block(Hash256::fromHex(previousHash), timestamp, difficulty);
+    block.setHash(Hash256::fromHex(dbHash));
     block.setNonce(nonce);
-    block.setMerkleRoot(merkleRoot);
+    block.setExtraNonce(extraNonce);
+    Hash256 merkleRootHash;
+    bool hasMerkleRoot = Hash256::tryFromHex(merkleRoot, merkleRootHash);
+    block.setMerkleRoot(merkleRootHash);
     block.setHeight(height);
     
     // Get transactions for this block
@@ -410,6 +416,11 @@ bool DatabaseAdapter::getBlock(const std::string& hash, Block& block) {
         PQclear(txRes);
     }
     
+    // Rows written before roots were tracked have an empty merkle_root
+    if (!hasMerkleRoot) {
+        block.updateMerkleRoot();
+    }
+    
     // Clean up
     PQclear(res);
     
@@ -507,7 +518,7 @@ bool DatabaseAdapter::saveTransaction(const Transaction& tx, const std::string&
     // Prepare query
     std::stringstream query;
     query << "INSERT INTO transactions (hash, from_address, to_address, amount, timestamp, transaction_type, block_hash, signature) VALUES ('"
-          << escapeString(tx.getHash()) << "', ";
+          << escapeString(tx.getHash().toHex()) << "', ";
     
     if (tx.getFromAddress().empty()) {
         query << "NULL, ";
@@ -772,9 +783,9 @@ bool DatabaseAdapter::saveMemoryProof(const MemoryProof& proof, const std::strin
     // Prepare query
     std::stringstream query;
     query << "INSERT INTO memory_proofs (hash, owner_address, file_hash, file_path, file_size, file_type, timestamp, transaction_hash) VALUES ('"
-          << escapeString(proof.getHash()) << "', '"
+          << escapeString(proof.getHash().toHex()) << "', '"
           << escapeString(proof.getOwnerAddress()) << "', '"
-          << escapeString(proof.getFileHash()) << "', '"
+          << escapeString(proof.getFileHash().toHex()) << "', '"
           << escapeString(proof.getFilePath()) << "', "
           << proof.getFileSize() << ", '"
           << escapeString(proof.getFileType()) << "', "
@@ -822,8 +833,8 @@ bool DatabaseAdapter::getMemoryProof(const std::string& hash, MemoryProof& proof
     uint64_t timestamp = std::stoull(PQgetvalue(res, 0, 6));
     
     // Create memory proof
-    proof = MemoryProof(ownerAddress, filePath, fileHash, fileSize, fileType, timestamp);
-    proof.setHash(proofHash);
+    proof = MemoryProof(ownerAddress, filePath, Hash256::fromHex(fileHash), fileSize, fileType, timestamp);
+    proof.setHash(Hash256::fromHex(proofHash));
     
     // Clean up
     PQclear(res);
@@ -858,8 +869,8 @@ std::vector<MemoryProof> DatabaseAdapter::getMemoryProofsForAddress(const std::s
         std::string fileType = PQgetvalue(res, i, 5);
         uint64_t timestamp = std::stoull(PQgetvalue(res, i, 6));
         
-        MemoryProof proof(ownerAddress, filePath, fileHash, fileSize, fileType, timestamp);
-        proof.setHash(proofHash);
+        MemoryProof proof(ownerAddress, filePath, Hash256::fromHex(fileHash), fileSize, fileType, timestamp);
+        proof.setHash(Hash256::fromHex(proofHash));
         
         proofs.push_back(proof);
     }
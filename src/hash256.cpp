@@ -0,0 +1,64 @@
+#include "../include/hash256.h"
+#include <stdexcept>
+
+namespace {
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+bool Hash256::tryFromHex(const std::string& hex, Hash256& out) {
+    if (hex.length() != SIZE * 2) {
+        return false;
+    }
+
+    Hash256 result;
+    for (size_t i = 0; i < SIZE; ++i) {
+        int hi = hexValue(hex[i * 2]);
+        int lo = hexValue(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        result.m_bytes[i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+
+    out = result;
+    return true;
+}
+
+Hash256 Hash256::fromHex(const std::string& hex) {
+    Hash256 result;
+    if (!tryFromHex(hex, result)) {
+        throw std::invalid_argument("Invalid hash hex string: " + hex);
+    }
+    return result;
+}
+
+std::string Hash256::toHex() const {
+    static const char digits[] = "0123456789abcdef";
+
+    std::string hex(SIZE * 2, '0');
+    for (size_t i = 0; i < SIZE; ++i) {
+        hex[i * 2] = digits[m_bytes[i] >> 4];
+        hex[i * 2 + 1] = digits[m_bytes[i] & 0x0f];
+    }
+    return hex;
+}
+
+bool Hash256::isZero() const {
+    for (uint8_t b : m_bytes) {
+        if (b != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::ostream& operator<<(std::ostream& os, const Hash256& hash) {
+    return os << hash.toHex();
+}
@@ -21,6 +21,7 @@ void uploadMemory(const std::string& filePath, const std::string& memoryType, co
 void mineBlock();
 void listMemories();
 void viewBlockchain();
+void auditBlockchain();
 void printTransactions();
 
 // Global state
@@ -29,13 +30,33 @@ std::unique_ptr<Wallet> g_wallet;
 std::unique_ptr<MemoryStorage> g_memoryStorage;
 bool g_running = true;
 
-int main() {
+int main(int argc, char* argv[]) {
     std::cout << "===============================================" << std::endl;
     std::cout << "  Ahmiyat Blockchain - Proof of Memories" << std::endl;
     std::cout << "===============================================" << std::endl;
 
+    // Keep every block body unless --prune <depth> is given
+    size_t pruneDepth = Blockchain::NO_PRUNING;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--prune" && i + 1 < argc) {
+            try {
+                pruneDepth = std::stoul(argv[i + 1]);
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid prune depth: " << argv[i + 1] << std::endl;
+                std::cerr << "Usage: " << argv[0] << " [--prune <depth>]" << std::endl;
+                return 1;
+            }
+            i++;
+        }
+    }
+
     // Initialize blockchain, wallet, and memory storage
     g_blockchain = std::make_unique<Blockchain>();
+    g_blockchain->setPruneDepth(pruneDepth);
+    if (!g_blockchain->loadChain("blockchain_data")) {
+        std::cerr << "Failed to open the block store; the chain will not be saved" << std::endl;
+    }
     g_memoryStorage = std::make_unique<MemoryStorage>("memories");
     
     // Create wallet directory if it doesn't exist
@@ -105,6 +126,9 @@ int main() {
         else if (command == "blockchain") {
             viewBlockchain();
         }
+        else if (command == "audit") {
+            auditBlockchain();
+        }
         else if (command == "transactions") {
             printTransactions();
         }
@@ -132,6 +156,7 @@ void printHelp() {
     std::cout << "  mine - Mine a new block and earn rewards" << std::endl;
     std::cout << "  memories - List your uploaded memories" << std::endl;
     std::cout << "  blockchain - View the current blockchain" << std::endl;
+    std::cout << "  audit - Re-validate every block, ignoring the validation checkpoint" << std::endl;
     std::cout << "  transactions - View pending transactions" << std::endl;
     std::cout << "  exit - Exit the application" << std::endl;
 }
@@ -320,7 +345,7 @@ void listMemories() {
             std::cout << i + 1 << ". " 
                      << "Type: " << MemoryProof::memoryTypeToString(memory.getType()) << ", "
                      << "Description: " << memory.getDescription() << ", "
-                     << "Hash: " << memory.getFileHash().substr(0, 10) << "..."
+                     << "Hash: " << memory.getFileHash().toHex().substr(0, 10) << "..."
                      << std::endl;
         }
     } catch (const std::exception& e) {
@@ -333,25 +358,40 @@ void viewBlockchain() {
     
     std::cout << "Blockchain Information:" << std::endl;
     std::cout << "  Chain length: " << chainSize << " blocks" << std::endl;
-    std::cout << "  Is valid: " << (g_blockchain->isChainValid() ? "Yes" : "No") << std::endl;
+    if (g_blockchain->getPrunedHeight() > 0) {
+        std::cout << "  Pruned: bodies below block " << g_blockchain->getPrunedHeight() << std::endl;
+    }
+    
+    ChainValidationResult validation = g_blockchain->validateChain();
+    if (validation.valid) {
+        std::cout << "  Is valid: Yes" << std::endl;
+    } else {
+        std::cout << "  Is valid: No (block " << validation.invalidHeight << ": "
+                  << validation.error << ")" << std::endl;
+    }
     
     char viewDetails;
     std::cout << "View detailed blocks? (y/n): ";
     std::cin >> viewDetails;
     
     if (viewDetails == 'y' || viewDetails == 'Y') {
-        std::vector<Block> chain = g_blockchain->getChain();
+        std::shared_ptr<const ChainSnapshot> chain = g_blockchain->getChainSnapshot();
         
-        for (size_t i = 0; i < chain.size(); ++i) {
-            const auto& block = chain[i];
-            std::cout << "\nBlock #" << block.getIndex() << ":" << std::endl;
-            std::cout << "  Hash: " << block.getHash() << std::endl;
-            std::cout << "  Previous Hash: " << block.getPreviousHash() << std::endl;
-            std::cout << "  Timestamp: " << block.getTimestamp() << std::endl;
-            std::cout << "  Nonce: " << block.getNonce() << std::endl;
+        for (size_t i = 0; i < chain->size(); ++i) {
+            const auto& header = (*chain)[i];
+            std::cout << "\nBlock #" << header.getIndex() << ":" << std::endl;
+            std::cout << "  Hash: " << header.getHash() << std::endl;
+            std::cout << "  Previous Hash: " << header.getPreviousHash() << std::endl;
+            std::cout << "  Timestamp: " << header.getTimestamp() << std::endl;
+            std::cout << "  Nonce: " << header.getNonce() << std::endl;
+            std::cout << "  Transactions: " << header.getTransactionCount() << std::endl;
+            
+            std::shared_ptr<const Block> block = g_blockchain->getBlock(i);
+            if (!block) {
+                continue;
+            }
             
-            const auto& transactions = block.getTransactions();
-            std::cout << "  Transactions: " << transactions.size() << std::endl;
+            const auto& transactions = block->getTransactions();
             
             for (size_t j = 0; j < transactions.size(); ++j) {
                 const auto& tx = transactions[j];
@@ -372,6 +412,18 @@ void viewBlockchain() {
     }
 }
 
+void auditBlockchain() {
+    ChainValidationResult validation = g_blockchain->validateChain(ValidationMode::FULL_AUDIT);
+
+    std::cout << "Audited " << validation.blocksChecked << " blocks" << std::endl;
+    if (validation.valid) {
+        std::cout << "  Chain is valid" << std::endl;
+    } else {
+        std::cout << "  Invalid block " << validation.invalidHeight << ": "
+                  << validation.error << std::endl;
+    }
+}
+
 void printTransactions() {
     std::vector<Transaction> pendingTxs = g_blockchain->getPendingTransactions();
     
@@ -1,5 +1,6 @@
 #include "../include/memory_proof.h"
 #include "../include/utils.h"
+#include "../include/sha256.h"
 #include <sstream>
 #include <stdexcept>
 #include <iostream>
@@ -7,42 +8,58 @@
 MemoryProof::MemoryProof(const std::string& filePath, 
                          MemoryType type, 
                          const std::string& uploader, 
-                         const std::string& description)
+                         const std::string& description,
+                         ContentHashMode hashMode)
     : m_type(type),
       m_uploader(uploader),
       m_description(description),
-      m_timestamp(std::time(nullptr)) {
+      m_timestamp(std::time(nullptr)),
+      m_hashMode(hashMode) {
     
-    // Calculate hash of the file
-    m_fileHash = ahmiyat::utils::sha256File(filePath);
+    // Calculate hash of the file. The tree root is the content key in
+    // either mode, so a SHA-256 proof hashes the file as a tree as well
+    if (m_hashMode == ContentHashMode::CHUNKED_TREE) {
+        ahmiyat::utils::FileTreeHash tree = ahmiyat::utils::sha256FileTree(filePath);
+        m_fileHash = tree.root;
+        m_contentKey = tree.root;
+        m_chunkHashes = std::move(tree.chunkHashes);
+    } else {
+        m_fileHash = ahmiyat::utils::sha256FileDigest(filePath);
+        m_contentKey = ahmiyat::utils::sha256FileTree(filePath).root;
+    }
 }
 
-MemoryProof::MemoryProof(const std::string& fileHash,
+MemoryProof::MemoryProof(const Hash256& fileHash,
                          MemoryType type,
                          const std::string& uploader,
                          const std::string& description,
                          time_t timestamp,
-                         const std::string& signature)
+                         const std::string& signature,
+                         ContentHashMode hashMode)
     : m_fileHash(fileHash),
+      m_contentKey(fileHash),
       m_type(type),
       m_uploader(uploader),
       m_description(description),
       m_timestamp(timestamp),
-      m_signature(signature) {
+      m_signature(signature),
+      m_hashMode(hashMode) {
 }
 
 // Constructor for database reconstruction
 MemoryProof::MemoryProof(const std::string& ownerAddress, 
                          const std::string& filePath, 
-                         const std::string& fileHash, 
+                         const Hash256& fileHash, 
                          uint64_t fileSize, 
                          const std::string& fileType, 
                          uint64_t timestamp)
     : m_fileHash(fileHash),
+      m_contentKey(fileHash),
       m_type(MemoryType::TEXT), // Default type, will be set based on fileType below
       m_uploader(ownerAddress),
       m_description(filePath),  // Use filePath as description for now
-      m_timestamp(timestamp) {
+      m_timestamp(timestamp),
+      m_hashMode(ContentHashMode::SHA256) {
     
     // Convert fileType string to MemoryType enum
     if (fileType == "IMAGE") {
@@ -62,8 +79,8 @@ void MemoryProof::signMemory(const std::string& privateKey) {
     }
     
     // Calculate the hash and sign it with the private key
-    std::string proofHash = calculateHash();
-    m_signature = ahmiyat::utils::sign(privateKey, proofHash);
+    Hash256 proofHash = calculateHash();
+    m_signature = ahmiyat::utils::sign(privateKey, proofHash.toHex());
 }
 
 bool MemoryProof::isValid() const {
@@ -75,13 +92,26 @@ bool MemoryProof::isValid() const {
         return false;
     }
     
-    return ahmiyat::utils::verify(m_uploader, m_signature, calculateHash());
+    return ahmiyat::utils::verify(m_uploader, m_signature, calculateHash().toHex());
 }
 
-std::string MemoryProof::calculateHash() const {
-    std::stringstream ss;
-    ss << m_fileHash << memoryTypeToString(m_type) << m_uploader << m_description << m_timestamp;
-    return ahmiyat::utils::sha256(ss.str());
+Hash256 MemoryProof::calculateHash() const {
+    ahmiyat::utils::Sha256 ctx;
+    ctx.update(m_fileHash);
+    ctx.updateString(contentHashModeToString(m_hashMode));
+    ctx.updateString(memoryTypeToString(m_type));
+    ctx.updateString(m_uploader);
+    ctx.updateString(m_description);
+    ctx.updateUint64(static_cast<uint64_t>(m_timestamp));
+    return ctx.final();
+}
+
+bool MemoryProof::verifyChunk(size_t chunkIndex, const void* data, size_t length) const {
+    if (m_hashMode != ContentHashMode::CHUNKED_TREE || chunkIndex >= m_chunkHashes.size()) {
+        return false;
+    }
+    
+    return ahmiyat::utils::sha256TreeLeaf(data, length) == m_chunkHashes[chunkIndex];
 }
 
 uint32_t MemoryProof::calculateProofDifficulty() const {
@@ -102,7 +132,7 @@ uint32_t MemoryProof::calculateProofDifficulty() const {
     }
 }
 
-std::string MemoryProof::getFileHash() const {
+Hash256 MemoryProof::getFileHash() const {
     return m_fileHash;
 }
 
@@ -126,10 +156,39 @@ std::string MemoryProof::getSignature() const {
     return m_signature;
 }
 
-std::string MemoryProof::getProofHash() const {
+Hash256 MemoryProof::getProofHash() const {
     return calculateHash();
 }
 
+MemoryProof::ContentHashMode MemoryProof::getContentHashMode() const {
+    return m_hashMode;
+}
+
+Hash256 MemoryProof::getContentKey() const {
+    return m_contentKey;
+}
+
+const std::vector<Hash256>& MemoryProof::getChunkHashes() const {
+    return m_chunkHashes;
+}
+
+std::string MemoryProof::contentHashModeToString(ContentHashMode mode) {
+    switch (mode) {
+        case ContentHashMode::CHUNKED_TREE:
+            return "CHUNKED_TREE";
+        case ContentHashMode::SHA256:
+        default:
+            return "SHA256";
+    }
+}
+
+MemoryProof::ContentHashMode MemoryProof::stringToContentHashMode(const std::string& modeStr) {
+    if (modeStr == "SHA256") return ContentHashMode::SHA256;
+    if (modeStr == "CHUNKED_TREE") return ContentHashMode::CHUNKED_TREE;
+    
+    throw std::invalid_argument("Unknown content hash mode: " + modeStr);
+}
+
 std::string MemoryProof::memoryTypeToString(MemoryType type) {
     switch (type) {
         case MemoryType::IMAGE:
@@ -157,7 +216,8 @@ MemoryProof::MemoryType MemoryProof::stringToMemoryType(const std::string& typeS
 std::string MemoryProof::toJson() const {
     std::stringstream ss;
     ss << "{";
-    ss << "\"fileHash\":\"" << ahmiyat::utils::jsonEscape(m_fileHash) << "\",";
+    ss << "\"fileHash\":\"" << ahmiyat::utils::jsonEscape(m_fileHash.toHex()) << "\",";
+    ss << "\"hashMode\":\"" << contentHashModeToString(m_hashMode) << "\",";
     ss << "\"type\":\"" << memoryTypeToString(m_type) << "\",";
     ss << "\"uploader\":\"" << ahmiyat::utils::jsonEscape(m_uploader) << "\",";
     ss << "\"description\":\"" << ahmiyat::utils::jsonEscape(m_description) << "\",";
@@ -172,5 +232,55 @@ MemoryProof MemoryProof::fromJson(const std::string& json) {
     // In a real implementation, this would parse the JSON and reconstruct the memory proof
     // For this example, we'll create a dummy memory proof
     std::cerr << "MemoryProof::fromJson not fully implemented" << std::endl;
-    return MemoryProof("dummy_hash", MemoryType::MEME, "dummy_address", "dummy_description", std::time(nullptr), "");
+    return MemoryProof(Hash256(), MemoryType::MEME, "dummy_address", "dummy_description", std::time(nullptr), "");
+}
+
+void MemoryProof::serialize(ahmiyat::utils::BinaryWriter& writer) const {
+    writer.writeHash(m_fileHash);
+    writer.writeUint8(static_cast<uint8_t>(m_type));
+    writer.writeString(m_uploader);
+    writer.writeString(m_description);
+    writer.writeUint64(static_cast<uint64_t>(m_timestamp));
+    writer.writeString(m_signature);
+    writer.writeUint8(static_cast<uint8_t>(m_hashMode));
+    writer.writeUint32(static_cast<uint32_t>(m_chunkHashes.size()));
+    for (const auto& hash : m_chunkHashes) {
+        writer.writeHash(hash);
+    }
+    writer.writeHash(m_contentKey);
+}
+
+bool MemoryProof::deserialize(ahmiyat::utils::BinaryReader& reader, MemoryProof& proof) {
+    uint8_t type = 0;
+    uint64_t timestamp = 0;
+    uint8_t hashMode = 0;
+    uint32_t chunkCount = 0;
+    
+    reader.readHash(proof.m_fileHash);
+    reader.readUint8(type);
+    reader.readString(proof.m_uploader);
+    reader.readString(proof.m_description);
+    reader.readUint64(timestamp);
+    reader.readString(proof.m_signature);
+    reader.readUint8(hashMode);
+    reader.readUint32(chunkCount);
+    
+    if (reader.failed() || type > static_cast<uint8_t>(MemoryType::TEXT) ||
+        hashMode > static_cast<uint8_t>(ContentHashMode::CHUNKED_TREE) ||
+        chunkCount > reader.remaining() / Hash256::SIZE) {
+        return false;
+    }
+    
+    proof.m_type = static_cast<MemoryType>(type);
+    proof.m_timestamp = static_cast<time_t>(timestamp);
+    proof.m_hashMode = static_cast<ContentHashMode>(hashMode);
+    proof.m_chunkHashes.resize(chunkCount);
+    for (auto& hash : proof.m_chunkHashes) {
+        reader.readHash(hash);
+    }
+    reader.readHash(proof.m_contentKey);
+    
+    // A tree proof's file hash is its content key
+    return !reader.failed() &&
+           (proof.m_hashMode != ContentHashMode::CHUNKED_TREE || proof.m_contentKey == proof.m_fileHash);
 }
@@ -1,10 +1,13 @@
 #include "../include/memory_storage.h"
 #include "../include/utils.h"
+#include "../include/binary_io.h"
+#include "../include/file_mapping.h"
+#include <cstdio>
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
 #include <algorithm>
-#include <sstream>
+#include <sys/stat.h>
 
 MemoryStorage::MemoryStorage(const std::string& baseDir) : m_baseDir(baseDir) {
     initializeStorage();
@@ -37,7 +40,8 @@ MemoryProof MemoryStorage::storeMemory(const std::string& filePath,
                                       MemoryProof::MemoryType type, 
                                       const std::string& uploader, 
                                       const std::string& description,
-                                      const std::string& privateKey) {
+                                      const std::string& privateKey,
+                                      MemoryProof::ContentHashMode hashMode) {
     std::lock_guard<std::mutex> lock(m_storageMutex);
     
     if (!fs::exists(filePath)) {
@@ -51,29 +55,27 @@ MemoryProof MemoryStorage::storeMemory(const std::string& filePath,
     }
     
     // Create the memory proof
-    MemoryProof proof(filePath, type, uploader, description);
+    MemoryProof proof(filePath, type, uploader, description, hashMode);
     
     // Sign the proof with the uploader's private key
     proof.signMemory(privateKey);
     
-    // Check if this file already exists in the storage
-    std::string fileHash = proof.getFileHash();
-    if (memoryExists(fileHash)) {
-        throw std::runtime_error("Memory file already exists with hash: " + fileHash);
+    // Check if this file already exists in the storage, whichever hash
+    // mode it was stored with
+    Hash256 fileHash = proof.getFileHash();
+    if (isKnownMemory(proof)) {
+        throw std::runtime_error("Memory file already exists with hash: " + fileHash.toHex());
     }
     
-    // Determine storage location based on memory type
-    std::string storagePath = getStoragePath(fileHash);
+    // Update indexes first, so the file lands in its type's folder
+    addToIndex(uploader, proof);
     
     // Copy the file to the storage location
-    if (!ahmiyat::utils::copyFile(filePath, storagePath)) {
+    if (!ahmiyat::utils::copyFile(filePath, getStoragePath(fileHash))) {
+        removeFromIndex(uploader, fileHash);
         throw std::runtime_error("Failed to copy memory file to storage");
     }
     
-    // Update indexes
-    m_memoryIndex[fileHash] = proof;
-    m_addressToMemories[uploader].push_back(fileHash);
-    
     std::cout << "Memory stored: " << fileHash << " (" 
               << fileSize / 1024 << " KB) by " << uploader.substr(0, 10) << "..." << std::endl;
     
@@ -83,15 +85,18 @@ MemoryProof MemoryStorage::storeMemory(const std::string& filePath,
     return proof;
 }
 
-std::string MemoryStorage::retrieveMemory(const std::string& fileHash) const {
-    if (!memoryExists(fileHash)) {
-        throw std::runtime_error("Memory does not exist with hash: " + fileHash);
+std::string MemoryStorage::retrieveMemory(const Hash256& fileHash) const {
+    std::lock_guard<std::mutex> lock(m_storageMutex);
+    
+    if (m_memoryIndex.find(fileHash) == m_memoryIndex.end()) {
+        throw std::runtime_error("Memory does not exist with hash: " + fileHash.toHex());
     }
     
     return getStoragePath(fileHash);
 }
 
 std::vector<MemoryProof> MemoryStorage::getMemoriesByAddress(const std::string& address) const {
+    std::lock_guard<std::mutex> lock(m_storageMutex);
     std::vector<MemoryProof> result;
     
     auto it = m_addressToMemories.find(address);
@@ -108,6 +113,7 @@ std::vector<MemoryProof> MemoryStorage::getMemoriesByAddress(const std::string&
 }
 
 size_t MemoryStorage::getMemoryCount(const std::string& address) const {
+    std::lock_guard<std::mutex> lock(m_storageMutex);
     auto it = m_addressToMemories.find(address);
     if (it != m_addressToMemories.end()) {
         return it->second.size();
@@ -115,11 +121,56 @@ size_t MemoryStorage::getMemoryCount(const std::string& address) const {
     return 0;
 }
 
-bool MemoryStorage::memoryExists(const std::string& fileHash) const {
+bool MemoryStorage::memoryExists(const Hash256& fileHash) const {
+    std::lock_guard<std::mutex> lock(m_storageMutex);
     return m_memoryIndex.find(fileHash) != m_memoryIndex.end();
 }
 
+bool MemoryStorage::memoryExists(const MemoryProof& proof) const {
+    std::lock_guard<std::mutex> lock(m_storageMutex);
+    return isKnownMemory(proof);
+}
+
+bool MemoryStorage::verifyMemoryChunk(const Hash256& fileHash, size_t chunkIndex) const {
+    // Copy what is needed under the lock and read the file outside it
+    MemoryProof proof;
+    std::string storagePath;
+    {
+        std::lock_guard<std::mutex> lock(m_storageMutex);
+        auto it = m_memoryIndex.find(fileHash);
+        if (it == m_memoryIndex.end()) {
+            std::cerr << "Memory does not exist with hash: " << fileHash << std::endl;
+            return false;
+        }
+        proof = it->second;
+        storagePath = getStoragePath(fileHash);
+    }
+    
+    if (proof.getContentHashMode() != MemoryProof::ContentHashMode::CHUNKED_TREE ||
+        chunkIndex >= proof.getChunkHashes().size()) {
+        std::cerr << "No chunk hash recorded for chunk " << chunkIndex << " of " << fileHash << std::endl;
+        return false;
+    }
+    
+    std::ifstream file(storagePath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open stored memory: " << fileHash << std::endl;
+        return false;
+    }
+    
+    std::vector<char> chunk(ahmiyat::utils::TREE_HASH_CHUNK_SIZE);
+    file.seekg(static_cast<std::streamoff>(chunkIndex * ahmiyat::utils::TREE_HASH_CHUNK_SIZE));
+    file.read(chunk.data(), chunk.size());
+    if (file.bad()) {
+        std::cerr << "Failed to read stored memory: " << fileHash << std::endl;
+        return false;
+    }
+    
+    return proof.verifyChunk(chunkIndex, chunk.data(), static_cast<size_t>(file.gcount()));
+}
+
 std::vector<std::string> MemoryStorage::getAllUploaderAddresses() const {
+    std::lock_guard<std::mutex> lock(m_storageMutex);
     std::vector<std::string> addresses;
     addresses.reserve(m_addressToMemories.size());
     
@@ -130,11 +181,37 @@ std::vector<std::string> MemoryStorage::getAllUploaderAddresses() const {
     return addresses;
 }
 
-std::string MemoryStorage::calculateFileHash(const std::string& filePath) const {
-    return ahmiyat::utils::sha256File(filePath);
+Hash256 MemoryStorage::calculateFileHash(const std::string& filePath) const {
+    return ahmiyat::utils::sha256FileDigest(filePath);
+}
+
+bool MemoryStorage::isKnownMemory(const MemoryProof& proof) const {
+    // Callers hold m_storageMutex
+    return m_memoryIndex.count(proof.getFileHash()) > 0 || m_filesByContentKey.count(proof.getContentKey()) > 0;
+}
+
+void MemoryStorage::addToIndex(const std::string& uploader, const MemoryProof& proof) {
+    Hash256 fileHash = proof.getFileHash();
+    m_memoryIndex[fileHash] = proof;
+    m_addressToMemories[uploader].push_back(fileHash);
+    m_filesByContentKey[proof.getContentKey()] = fileHash;
+}
+
+void MemoryStorage::removeFromIndex(const std::string& uploader, const Hash256& fileHash) {
+    m_filesByContentKey.erase(m_memoryIndex.at(fileHash).getContentKey());
+    m_memoryIndex.erase(fileHash);
+    std::vector<Hash256>& memories = m_addressToMemories[uploader];
+    memories.pop_back();
+    if (memories.empty()) {
+        m_addressToMemories.erase(uploader);
+    }
 }
 
-std::string MemoryStorage::getStoragePath(const std::string& fileHash) const {
+std::string MemoryStorage::getIndexPath() const {
+    return m_baseDir + "/memory_index.dat";
+}
+
+std::string MemoryStorage::getStoragePath(const Hash256& fileHash) const {
     // Determine the folder based on memory type
     std::string subFolder = "other";
     
@@ -163,152 +240,135 @@ std::string MemoryStorage::getStoragePath(const std::string& fileHash) const {
         subFolder = "other";
     }
     
-    return m_baseDir + "/" + subFolder + "/" + fileHash;
+    return m_baseDir + "/" + subFolder + "/" + fileHash.toHex();
 }
 
 bool MemoryStorage::saveIndex() const {
-    try {
-        std::string indexPath = m_baseDir + "/memory_index.json";
-        
-        std::ofstream file(indexPath);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open memory index file for saving: " << indexPath << std::endl;
-            return false;
-        }
-        
-        file << "{\n";
-        file << "  \"memories\": [\n";
-        
-        size_t count = 0;
-        for (const auto& entry : m_memoryIndex) {
-            file << "    " << entry.second.toJson();
-            if (++count < m_memoryIndex.size()) {
-                file << ",";
-            }
-            file << "\n";
+    // One record per memory in each uploader's upload order: the proof,
+    // with its chunk hashes and content key
+    ahmiyat::utils::BinaryWriter payload;
+    payload.writeUint64(m_memoryIndex.size());
+    for (const auto& entry : m_addressToMemories) {
+        for (const auto& fileHash : entry.second) {
+            m_memoryIndex.at(fileHash).serialize(payload);
         }
-        
-        file << "  ],\n";
-        file << "  \"addressToMemories\": {\n";
-        
-        count = 0;
-        for (const auto& entry : m_addressToMemories) {
-            file << "    \"" << entry.first << "\": " 
-                 << ahmiyat::utils::vectorToJsonArray(entry.second);
-            
-            if (++count < m_addressToMemories.size()) {
-                file << ",";
-            }
-            file << "\n";
+    }
+    
+    ahmiyat::utils::BinaryWriter header;
+    header.writeUint32(INDEX_MAGIC);
+    header.writeUint32(INDEX_VERSION);
+    header.writeUint64(payload.size());
+    header.writeUint32(ahmiyat::utils::crc32(payload.bytes().data(), payload.size()));
+    
+    // Write and flush beside the old index, then rename over it
+    std::string indexPath = getIndexPath();
+    std::string tempPath = indexPath + ".tmp";
+    {
+        ahmiyat::utils::FileDescriptor file(tempPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC);
+        if (file.fd < 0 || !ahmiyat::utils::writeAll(file.fd, header.bytes().data(), header.size()) ||
+            !ahmiyat::utils::writeAll(file.fd, payload.bytes().data(), payload.size()) ||
+            ::fdatasync(file.fd) != 0) {
+            std::cerr << "Failed to write memory index: " << tempPath << std::endl;
+            return false;
         }
-        
-        file << "  }\n";
-        file << "}\n";
-        
-        file.close();
-        std::cout << "Memory index saved to: " << indexPath << std::endl;
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error saving memory index: " << e.what() << std::endl;
+    }
+    if (std::rename(tempPath.c_str(), indexPath.c_str()) != 0 || !ahmiyat::utils::syncDirectory(m_baseDir)) {
+        std::cerr << "Failed to replace memory index: " << indexPath << std::endl;
         return false;
     }
+    
+    return true;
 }
 
 bool MemoryStorage::loadIndex() {
-    try {
-        std::string indexPath = m_baseDir + "/memory_index.json";
-        
-        if (!fs::exists(indexPath)) {
-            std::cout << "No existing memory index found. Creating new index." << std::endl;
-            return false;
-        }
-        
-        std::cout << "Loading memory index from: " << indexPath << std::endl;
-        
-        // Read the entire file
-        std::ifstream file(indexPath);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open memory index file for loading" << std::endl;
+    std::string indexPath = getIndexPath();
+    if (!fs::exists(indexPath)) {
+        std::cout << "No existing memory index found. Creating new index." << std::endl;
+        return false;
+    }
+    
+    ahmiyat::utils::FileDescriptor file(indexPath);
+    struct stat st;
+    if (file.fd < 0 || ::fstat(file.fd, &st) != 0) {
+        std::cerr << "Failed to open memory index file for loading" << std::endl;
+        return false;
+    }
+    
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    ahmiyat::utils::FileMapping mapping(file.fd, fileSize, MADV_SEQUENTIAL);
+    if (!mapping.valid() || fileSize < INDEX_HEADER_SIZE) {
+        std::cerr << "Invalid memory index file: " << indexPath << std::endl;
+        return false;
+    }
+    
+    ahmiyat::utils::BinaryReader header(mapping.bytes(), INDEX_HEADER_SIZE);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t length = 0;
+    uint32_t crc = 0;
+    header.readUint32(magic);
+    header.readUint32(version);
+    header.readUint64(length);
+    header.readUint32(crc);
+    
+    const uint8_t* payload = mapping.bytes() + INDEX_HEADER_SIZE;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION || length != fileSize - INDEX_HEADER_SIZE ||
+        ahmiyat::utils::crc32(payload, length) != crc) {
+        std::cerr << "Invalid memory index file: " << indexPath << std::endl;
+        return false;
+    }
+    
+    // Parse into locals so a damaged index leaves the storage empty
+    // rather than half loaded
+    std::unordered_map<Hash256, MemoryProof> memoryIndex;
+    std::unordered_map<std::string, std::vector<Hash256>> addressToMemories;
+    std::unordered_map<Hash256, Hash256> filesByContentKey;
+    
+    ahmiyat::utils::BinaryReader reader(payload, length);
+    uint64_t count = 0;
+    if (!reader.readUint64(count) || count > reader.remaining()) {
+        std::cerr << "Invalid memory index file: " << indexPath << std::endl;
+        return false;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        MemoryProof proof;
+        if (!MemoryProof::deserialize(reader, proof)) {
+            std::cerr << "Invalid memory index file: " << indexPath << std::endl;
             return false;
         }
         
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        std::string json = buffer.str();
-        file.close();
-        
-        // Parse the JSON (simplified implementation)
-        // In a real implementation, we would use a JSON parser library
-        
-        // Clear existing data
-        m_memoryIndex.clear();
-        m_addressToMemories.clear();
-        
-        // Find and extract memories array
-        size_t memoriesStart = json.find("\"memories\"");
-        if (memoriesStart != std::string::npos) {
-            memoriesStart = json.find("[", memoriesStart);
-            if (memoriesStart != std::string::npos) {
-                size_t memoriesEnd = json.find("]", memoriesStart);
-                if (memoriesEnd != std::string::npos) {
-                    std::string memoriesJson = json.substr(memoriesStart + 1, memoriesEnd - memoriesStart - 1);
-                    
-                    // Split into individual memory JSONs (very simplified)
-                    size_t pos = 0;
-                    while (pos < memoriesJson.length()) {
-                        size_t memStart = memoriesJson.find("{", pos);
-                        if (memStart == std::string::npos) break;
-                        
-                        size_t memEnd = memoriesJson.find("}", memStart);
-                        if (memEnd == std::string::npos) break;
-                        
-                        // Find the next comma or end of array
-                        size_t nextComma = memoriesJson.find(",", memEnd);
-                        
-                        // Extract the memory JSON
-                        std::string memJson = memoriesJson.substr(memStart, memEnd - memStart + 1);
-                        
-                        // Parse the memory
-                        MemoryProof proof = MemoryProof::fromJson(memJson);
-                        
-                        // Add to index
-                        std::string fileHash = proof.getFileHash();
-                        m_memoryIndex[fileHash] = proof;
-                        m_addressToMemories[proof.getUploader()].push_back(fileHash);
-                        
-                        // Move to next memory
-                        if (nextComma != std::string::npos) {
-                            pos = nextComma + 1;
-                        } else {
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-        
-        std::cout << "Loaded " << m_memoryIndex.size() << " memories from " 
-                  << m_addressToMemories.size() << " addresses" << std::endl;
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error loading memory index: " << e.what() << std::endl;
+        Hash256 fileHash = proof.getFileHash();
+        addressToMemories[proof.getUploader()].push_back(fileHash);
+        filesByContentKey[proof.getContentKey()] = fileHash;
+        memoryIndex[fileHash] = std::move(proof);
+    }
+    if (reader.failed() || reader.remaining() != 0) {
+        std::cerr << "Invalid memory index file: " << indexPath << std::endl;
         return false;
     }
+    
+    m_memoryIndex = std::move(memoryIndex);
+    m_addressToMemories = std::move(addressToMemories);
+    m_filesByContentKey = std::move(filesByContentKey);
+    
+    std::cout << "Loaded " << m_memoryIndex.size() << " memories from " 
+              << m_addressToMemories.size() << " addresses" << std::endl;
+    return true;
 }
 
 bool MemoryStorage::storeMemory(const std::string& uploader, const MemoryProof& proof) {
     std::lock_guard<std::mutex> lock(m_storageMutex);
     
-    // Check if this file already exists in the storage
-    std::string fileHash = proof.getFileHash();
-    if (memoryExists(fileHash)) {
+    // Check if this file already exists in the storage, whichever hash
+    // mode it was stored with
+    Hash256 fileHash = proof.getFileHash();
+    if (isKnownMemory(proof)) {
         std::cerr << "Memory file already exists with hash: " << fileHash << std::endl;
         return false;
     }
     
     // Add to indexes
-    m_memoryIndex[fileHash] = proof;
-    m_addressToMemories[uploader].push_back(fileHash);
+    addToIndex(uploader, proof);
     
     std::cout << "Memory proof stored in index: " << fileHash << " by " 
               << uploader.substr(0, 10) << "..." << std::endl;
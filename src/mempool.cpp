@@ -0,0 +1,237 @@
+#include "../include/mempool.h"
+#include <algorithm>
+#include <functional>
+
+Mempool::Mempool(size_t maxTransfers)
+    : m_log(std::make_shared<const Snapshot>()),
+      m_maxTransfers(maxTransfers),
+      m_transferCount(0),
+      m_evictedCount(0) {
+}
+
+MempoolAddResult Mempool::add(const Transaction& transaction, double confirmedSenderBalance) {
+    Hash256 hash = transaction.getHash();
+    if (!claimHash(hash, true)) {
+        return MempoolAddResult::DUPLICATE;
+    }
+
+    std::string fromAddress = transaction.getFromAddress();
+    double amount = transaction.getAmount();
+    bool transfer = isTransfer(transaction);
+
+    if (transfer) {
+        // Check and reserve under the sender's shard lock, so two spends
+        // from one address cannot both pass against the same balance.
+        // Pending credits are left out: the transfer paying them could be
+        // evicted, and a spend admitted against it would then overdraw
+        AccountShard& shard = accountShard(fromAddress);
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        Account& account = shard.accounts[fromAddress];
+        if (confirmedSenderBalance - account.debits < amount) {
+            if (account.pending == 0) {
+                shard.accounts.erase(fromAddress);
+            }
+            lock.unlock();
+            releaseHash(hash);
+            return MempoolAddResult::INSUFFICIENT_BALANCE;
+        }
+        account.delta -= amount;
+        account.debits += amount;
+        account.pending++;
+    } else {
+        applyDelta(fromAddress, -amount);
+    }
+    applyDelta(transaction.getToAddress(), amount);
+
+    // Counted before it enters the log, so an eviction that removes it
+    // never sees the count go below zero
+    bool overLimit = transfer && m_transferCount.fetch_add(1) + 1 > m_maxTransfers;
+    append(transaction);
+
+    if (overLimit) {
+        evict();
+    }
+
+    return MempoolAddResult::ADDED;
+}
+
+void Mempool::addSystem(const Transaction& transaction) {
+    // Rewards are generated locally; two identical ones (same recipient and
+    // second) are both owed, so they are counted rather than rejected
+    claimHash(transaction.getHash(), false);
+    applyDelta(transaction.getFromAddress(), -transaction.getAmount());
+    applyDelta(transaction.getToAddress(), transaction.getAmount());
+    append(transaction);
+}
+
+void Mempool::remove(const std::vector<Transaction>& transactions) {
+    if (transactions.empty()) {
+        return;
+    }
+
+    std::unordered_map<Hash256, uint32_t> included;
+    for (const auto& tx : transactions) {
+        included[tx.getHash()]++;
+    }
+
+    std::vector<Transaction> removed;
+    {
+        std::lock_guard<std::mutex> lock(m_logMutex);
+
+        // Compact the log; transactions that arrived after the block's
+        // template was taken are kept in order
+        std::vector<Transaction> kept;
+        kept.reserve(m_log->size());
+        for (size_t i = 0; i < m_log->size(); ++i) {
+            const Transaction& tx = (*m_log)[i];
+            auto it = included.find(tx.getHash());
+            if (it != included.end() && it->second > 0) {
+                it->second--;
+                removed.push_back(tx);
+            } else {
+                kept.push_back(tx);
+            }
+        }
+
+        if (removed.empty()) {
+            return;
+        }
+        std::atomic_store(&m_log, std::make_shared<const Snapshot>(kept));
+    }
+
+    release(removed);
+}
+
+std::shared_ptr<const Mempool::Snapshot> Mempool::snapshot() const {
+    return std::atomic_load(&m_log);
+}
+
+double Mempool::getPendingDelta(const std::string& address) const {
+    const AccountShard& shard = accountShard(address);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.accounts.find(address);
+    return it != shard.accounts.end() ? it->second.delta : 0.0;
+}
+
+size_t Mempool::size() const {
+    return snapshot()->size();
+}
+
+uint64_t Mempool::getEvictedCount() const {
+    return m_evictedCount.load();
+}
+
+bool Mempool::isTransfer(const Transaction& transaction) {
+    // Signed client transfers; mining rewards are transfers from no one
+    return transaction.getType() == Transaction::TransactionType::COIN_TRANSFER &&
+           !transaction.getFromAddress().empty();
+}
+
+Mempool::TransactionShard& Mempool::transactionShard(const Hash256& hash) {
+    return m_transactionShards[std::hash<Hash256>()(hash) % SHARD_COUNT];
+}
+
+Mempool::AccountShard& Mempool::accountShard(const std::string& address) {
+    return m_accountShards[std::hash<std::string>()(address) % SHARD_COUNT];
+}
+
+const Mempool::AccountShard& Mempool::accountShard(const std::string& address) const {
+    return m_accountShards[std::hash<std::string>()(address) % SHARD_COUNT];
+}
+
+bool Mempool::claimHash(const Hash256& hash, bool unique) {
+    TransactionShard& shard = transactionShard(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    uint32_t& count = shard.counts[hash];
+    if (unique && count > 0) {
+        return false;
+    }
+    count++;
+    return true;
+}
+
+void Mempool::releaseHash(const Hash256& hash) {
+    TransactionShard& shard = transactionShard(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.counts.find(hash);
+    if (it != shard.counts.end() && --it->second == 0) {
+        shard.counts.erase(it);
+    }
+}
+
+void Mempool::applyDelta(const std::string& address, double change) {
+    AccountShard& shard = accountShard(address);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    Account& account = shard.accounts[address];
+    account.delta += change;
+    account.pending++;
+}
+
+void Mempool::undoDelta(const std::string& address, double change, double debit) {
+    AccountShard& shard = accountShard(address);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.accounts.find(address);
+    if (it == shard.accounts.end()) {
+        return;
+    }
+
+    it->second.delta -= change;
+    it->second.debits -= debit;
+    if (--it->second.pending == 0) {
+        shard.accounts.erase(it);
+    }
+}
+
+void Mempool::append(const Transaction& transaction) {
+    std::lock_guard<std::mutex> lock(m_logMutex);
+    std::atomic_store(&m_log, m_log->append(transaction));
+}
+
+void Mempool::evict() {
+    std::vector<Transaction> removed;
+    {
+        std::lock_guard<std::mutex> lock(m_logMutex);
+
+        // Another adder may have evicted already
+        size_t count = m_transferCount.load();
+        if (count <= m_maxTransfers) {
+            return;
+        }
+        size_t target = std::max(count - m_maxTransfers, m_maxTransfers / EVICTION_BATCH_DIVISOR);
+
+        // Oldest transfers first; rewards stay where they are
+        std::vector<Transaction> kept;
+        kept.reserve(m_log->size());
+        for (size_t i = 0; i < m_log->size(); ++i) {
+            const Transaction& tx = (*m_log)[i];
+            if (removed.size() < target && isTransfer(tx)) {
+                removed.push_back(tx);
+            } else {
+                kept.push_back(tx);
+            }
+        }
+        std::atomic_store(&m_log, std::make_shared<const Snapshot>(kept));
+    }
+
+    m_evictedCount.fetch_add(removed.size());
+    release(removed);
+}
+
+void Mempool::release(const std::vector<Transaction>& removed) {
+    // Undo what add() or addSystem() applied for transactions already taken
+    // out of the log
+    for (const auto& tx : removed) {
+        releaseHash(tx.getHash());
+        bool transfer = isTransfer(tx);
+        undoDelta(tx.getFromAddress(), -tx.getAmount(), transfer ? tx.getAmount() : 0.0);
+        undoDelta(tx.getToAddress(), tx.getAmount());
+        if (transfer) {
+            m_transferCount.fetch_sub(1);
+        }
+    }
+}
@@ -0,0 +1,177 @@
+#include "../include/miner.h"
+#include "../include/block.h"
+#include "../include/sha256.h"
+#include "../include/target.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Header bytes covered by the midstate; the nonce lies beyond them
+constexpr size_t MIDSTATE_SIZE = ahmiyat::utils::Sha256::BLOCK_SIZE;
+constexpr size_t TAIL_SIZE = Block::HEADER_SIZE - MIDSTATE_SIZE;
+constexpr size_t TAIL_NONCE_OFFSET = Block::HEADER_NONCE_OFFSET - MIDSTATE_SIZE;
+constexpr uint64_t NONCE_COUNT = uint64_t(UINT32_MAX) + 1;
+
+static_assert(Block::HEADER_NONCE_OFFSET >= MIDSTATE_SIZE,
+              "the nonce must follow the midstate prefix");
+static_assert(Block::HEADER_EXTRA_NONCE_OFFSET >= MIDSTATE_SIZE,
+              "the extra nonce must follow the midstate prefix");
+
+// Batches between updates of the shared progress counter, so workers do
+// not contend on it every batch
+constexpr uint64_t PROGRESS_INTERVAL = 64;
+
+// Little-endian integer encoding, matching Block::serializeHeader
+void storeLittleEndian(uint8_t* out, uint64_t value, size_t width) {
+    for (size_t i = 0; i < width; ++i) {
+        out[i] = static_cast<uint8_t>((value >> (i * 8)) & 0xff);
+    }
+}
+
+// One batch of header tails that differ only in their nonce, finished
+// from the shared midstate with one compression each
+class NonceBatch {
+public:
+    NonceBatch(const Block::Header& header, size_t lanes)
+        : m_tails(lanes),
+          m_messages(lanes),
+          m_lengths(lanes, TAIL_SIZE),
+          m_digests(lanes) {
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            std::memcpy(m_tails[lane].data(), header.data() + MIDSTATE_SIZE, TAIL_SIZE);
+            m_messages[lane] = m_tails[lane].data();
+        }
+    }
+
+    // Hash nonces firstNonce .. firstNonce + count - 1
+    void hash(const ahmiyat::utils::Sha256Midstate& midstate, uint32_t firstNonce, size_t count) {
+        for (size_t lane = 0; lane < count; ++lane) {
+            uint32_t nonce = firstNonce + static_cast<uint32_t>(lane);
+            storeLittleEndian(m_tails[lane].data() + TAIL_NONCE_OFFSET, nonce, sizeof(nonce));
+        }
+
+        midstate.finishBatch(m_messages.data(), m_lengths.data(), m_digests.data(), count);
+    }
+
+    const Hash256& digest(size_t lane) const { return m_digests[lane]; }
+
+private:
+    std::vector<std::array<uint8_t, TAIL_SIZE>> m_tails;
+    std::vector<const uint8_t*> m_messages;
+    std::vector<size_t> m_lengths;
+    std::vector<Hash256> m_digests;
+};
+
+} // namespace
+
+Miner::Miner(size_t threadCount) : m_threadCount(threadCount) {
+    if (m_threadCount == 0) {
+        m_threadCount = std::thread::hardware_concurrency();
+    }
+    if (m_threadCount == 0) {
+        m_threadCount = 1;
+    }
+}
+
+MiningResult Miner::mine(const Block& block, const std::atomic<bool>* cancel,
+                         std::atomic<uint64_t>* progress) const {
+    const Hash256 target = block.getTarget();
+    const size_t lanes = ahmiyat::utils::sha256BatchLanes();
+
+    MiningResult result;
+    if (target.isZero()) {
+        return result;
+    }
+
+    std::mutex resultMutex;
+    std::atomic<bool> found{false};
+    std::vector<uint64_t> threadHashes(m_threadCount, 0);
+    const auto start = std::chrono::steady_clock::now();
+
+    auto stopped = [&]() {
+        return found.load(std::memory_order_relaxed) ||
+               (cancel && cancel->load(std::memory_order_relaxed));
+    };
+
+    // Worker w sweeps extra nonces w, w + threads, w + 2 * threads, ...
+    // so no two workers ever hash the same header
+    auto worker = [&](size_t workerIndex) {
+        Block::Header header = block.serializeHeader();
+        time_t timestamp = block.getTimestamp();
+        uint64_t tried = 0;
+        uint64_t reported = 0;
+        uint64_t batches = 0;
+
+        for (uint64_t extraNonce = workerIndex; extraNonce <= UINT32_MAX && !stopped();
+             extraNonce += m_threadCount) {
+            // After the first sweep, keep the block time current; the
+            // timestamp lies in the first SHA-256 block, so the midstate
+            // is recomputed once per sweep
+            if (extraNonce >= m_threadCount) {
+                timestamp = std::max(timestamp, std::time(nullptr));
+            }
+            storeLittleEndian(header.data() + Block::HEADER_TIMESTAMP_OFFSET,
+                              static_cast<uint64_t>(timestamp), sizeof(uint64_t));
+            storeLittleEndian(header.data() + Block::HEADER_EXTRA_NONCE_OFFSET, extraNonce, sizeof(uint32_t));
+
+            const ahmiyat::utils::Sha256Midstate midstate(header.data(), MIDSTATE_SIZE);
+            NonceBatch batch(header, lanes);
+
+            for (uint64_t first = 0; first < NONCE_COUNT && !stopped(); first += lanes) {
+                size_t count = static_cast<size_t>(std::min<uint64_t>(lanes, NONCE_COUNT - first));
+                batch.hash(midstate, static_cast<uint32_t>(first), count);
+                tried += count;
+
+                if (progress && ++batches % PROGRESS_INTERVAL == 0) {
+                    progress->fetch_add(tried - reported, std::memory_order_relaxed);
+                    reported = tried;
+                }
+
+                for (size_t lane = 0; lane < count; ++lane) {
+                    if (ahmiyat::utils::hashMeetsTarget(batch.digest(lane), target)) {
+                        std::lock_guard<std::mutex> lock(resultMutex);
+                        if (!result.found) {
+                            result.found = true;
+                            result.nonce = static_cast<uint32_t>(first + lane);
+                            result.extraNonce = static_cast<uint32_t>(extraNonce);
+                            result.timestamp = timestamp;
+                            result.hash = batch.digest(lane);
+                        }
+                        found.store(true, std::memory_order_relaxed);
+                        break;
+                    }
+                }
+            }
+        }
+
+        threadHashes[workerIndex] = tried;
+        if (progress) {
+            progress->fetch_add(tried - reported, std::memory_order_relaxed);
+        }
+    };
+
+    // The calling thread acts as worker 0
+    std::vector<std::thread> workers;
+    workers.reserve(m_threadCount - 1);
+    for (size_t i = 1; i < m_threadCount; ++i) {
+        workers.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.threadHashes = std::move(threadHashes);
+    for (uint64_t hashes : result.threadHashes) {
+        result.hashesTried += hashes;
+    }
+    result.cancelled = !result.found && cancel && cancel->load();
+    return result;
+}
@@ -0,0 +1,63 @@
+#include "../include/mining_telemetry.h"
+#include <algorithm>
+#include <cmath>
+
+void MiningTelemetry::record(const MiningResult& result, const Hash256& target) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_stats.totalHashes += result.hashesTried;
+    m_stats.totalSeconds += result.seconds;
+    m_stats.averageHashRate = m_stats.totalSeconds > 0.0 ? m_stats.totalHashes / m_stats.totalSeconds : 0.0;
+
+    m_stats.lastHashRate = result.seconds > 0.0 ? result.hashesTried / result.seconds : 0.0;
+    m_stats.lastThreadHashRates.clear();
+    for (uint64_t hashes : result.threadHashes) {
+        m_stats.lastThreadHashRates.push_back(result.seconds > 0.0 ? hashes / result.seconds : 0.0);
+    }
+
+    if (!result.found) {
+        if (result.cancelled) {
+            m_stats.searchesCancelled++;
+        } else {
+            m_stats.searchesFailed++;
+        }
+        return;
+    }
+
+    m_stats.blocksFound++;
+    if (m_stats.blocksFound == 1) {
+        m_stats.minSolveSeconds = result.seconds;
+        m_stats.maxSolveSeconds = result.seconds;
+    } else {
+        m_stats.minSolveSeconds = std::min(m_stats.minSolveSeconds, result.seconds);
+        m_stats.maxSolveSeconds = std::max(m_stats.maxSolveSeconds, result.seconds);
+    }
+
+    // First bucket whose bound the time does not exceed, else the overflow bucket
+    const auto& bounds = MiningStats::SOLVE_TIME_BOUNDS;
+    size_t bucket = std::lower_bound(bounds.begin(), bounds.end(), result.seconds) - bounds.begin();
+    m_stats.solveTimeHistogram[bucket]++;
+
+    m_solveSecondsTotal += result.seconds;
+    m_solvedHashesTotal += static_cast<double>(result.hashesTried);
+    m_expectedHashesTotal += expectedHashes(target);
+
+    m_stats.meanSolveSeconds = m_solveSecondsTotal / m_stats.blocksFound;
+    m_stats.meanHashesPerBlock = m_solvedHashesTotal / m_stats.blocksFound;
+    m_stats.meanExpectedHashesPerBlock = m_expectedHashesTotal / m_stats.blocksFound;
+}
+
+MiningStats MiningTelemetry::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+double MiningTelemetry::expectedHashes(const Hash256& target) {
+    // The target as a double; 53 bits of precision is plenty for a rate
+    double value = 0.0;
+    for (size_t i = 0; i < Hash256::SIZE; ++i) {
+        value = value * 256.0 + target.data()[i];
+    }
+
+    return std::ldexp(1.0, 256) / (value + 1.0);
+}
@@ -0,0 +1,832 @@
+#include "../include/sha256.h"
+#include <atomic>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define AHMIYAT_SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define AHMIYAT_SHA256_X86 0
+#endif
+
+namespace ahmiyat {
+namespace utils {
+
+// SHA-256 Constants (first 32 bits of the fractional parts of the cube roots of the first 64 primes)
+alignas(16) static constexpr uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// Initial hash values (first 32 bits of the fractional parts of the square roots of the first 8 primes)
+static constexpr uint32_t H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+// Rotate right (circular right shift) operation
+inline uint32_t rotr(uint32_t x, uint32_t n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+// SHA-256 functions
+inline uint32_t ch(uint32_t x, uint32_t y, uint32_t z) {
+    return (x & y) ^ (~x & z);
+}
+
+inline uint32_t maj(uint32_t x, uint32_t y, uint32_t z) {
+    return (x & y) ^ (x & z) ^ (y & z);
+}
+
+inline uint32_t sigma0(uint32_t x) {
+    return rotr(x, 2) ^ rotr(x, 13) ^ rotr(x, 22);
+}
+
+inline uint32_t sigma1(uint32_t x) {
+    return rotr(x, 6) ^ rotr(x, 11) ^ rotr(x, 25);
+}
+
+inline uint32_t gamma0(uint32_t x) {
+    return rotr(x, 7) ^ rotr(x, 18) ^ (x >> 3);
+}
+
+inline uint32_t gamma1(uint32_t x) {
+    return rotr(x, 17) ^ rotr(x, 19) ^ (x >> 10);
+}
+
+void sha256CompressScalar(uint32_t state[8], const uint8_t* blocks, size_t blockCount) {
+    for (size_t block = 0; block < blockCount; ++block) {
+        const uint8_t* chunk = blocks + block * Sha256::BLOCK_SIZE;
+        uint32_t w[64];
+
+        // Break chunk into 16 32-bit big-endian words
+        for (int i = 0; i < 16; ++i) {
+            w[i] = ((uint32_t)chunk[i * 4] << 24) |
+                   ((uint32_t)chunk[i * 4 + 1] << 16) |
+                   ((uint32_t)chunk[i * 4 + 2] << 8) |
+                   ((uint32_t)chunk[i * 4 + 3]);
+        }
+
+        // Extend the 16 words into 64 words
+        for (int i = 16; i < 64; ++i) {
+            w[i] = gamma1(w[i - 2]) + w[i - 7] + gamma0(w[i - 15]) + w[i - 16];
+        }
+
+        // Initialize working variables
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+        uint32_t f = state[5];
+        uint32_t g = state[6];
+        uint32_t h = state[7];
+
+        // Main loop
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1 = h + sigma1(e) + ch(e, f, g) + K[i] + w[i];
+            uint32_t t2 = sigma0(a) + maj(a, b, c);
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        // Add the compressed chunk to the current hash value
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#if AHMIYAT_SHA256_X86
+
+// Intel SHA extensions: two rounds per sha256rnds2, schedule via sha256msg1/msg2
+__attribute__((target("sha,sse4.1")))
+void sha256CompressShaNi(uint32_t state[8], const uint8_t* blocks, size_t blockCount) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    
+    // Rearrange the state into the ABEF/CDGH layout the instructions expect
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+    
+    for (size_t block = 0; block < blockCount; ++block) {
+        const uint8_t* chunk = blocks + block * Sha256::BLOCK_SIZE;
+        __m128i abefSave = state0;
+        __m128i cdghSave = state1;
+        
+        __m128i msg[4];
+        for (int i = 0; i < 4; ++i) {
+            msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(chunk + i * 16)), byteSwap);
+        }
+        
+        for (int group = 0; group < 16; ++group) {
+            __m128i wk = _mm_add_epi32(msg[group & 3], _mm_load_si128(reinterpret_cast<const __m128i*>(&K[group * 4])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+            
+            // Schedule the words for group + 4 into the slot just consumed
+            if (group < 12) {
+                __m128i w = _mm_sha256msg1_epu32(msg[group & 3], msg[(group + 1) & 3]);
+                w = _mm_add_epi32(w, _mm_alignr_epi8(msg[(group + 3) & 3], msg[(group + 2) & 3], 4));
+                msg[group & 3] = _mm_sha256msg2_epu32(w, msg[(group + 3) & 3]);
+            }
+            
+            wk = _mm_shuffle_epi32(wk, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, wk);
+        }
+        
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+    
+    // Back to the linear A..H layout
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+// Load word j of every lane's block as big-endian, transposed to [word][lane]
+template <size_t LANES>
+static inline void gatherWords(uint32_t words[16][LANES], const uint8_t* const blocks[LANES]) {
+    for (size_t lane = 0; lane < LANES; ++lane) {
+        for (int j = 0; j < 16; ++j) {
+            uint32_t word;
+            std::memcpy(&word, blocks[lane] + j * 4, sizeof(word));
+            words[j][lane] = __builtin_bswap32(word);
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i rotr8x(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+// One block for each of 8 independent messages; state is [word][lane]
+__attribute__((target("avx2")))
+static void compressLanesAvx2(uint32_t state[8][8], const uint8_t* const blocks[8]) {
+    alignas(32) uint32_t words[16][8];
+    gatherWords<8>(words, blocks);
+    
+    __m256i w[16];
+    for (int j = 0; j < 16; ++j) {
+        w[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(words[j]));
+    }
+    
+    __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[0]));
+    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[1]));
+    __m256i c = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[2]));
+    __m256i d = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[3]));
+    __m256i e = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[4]));
+    __m256i f = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[5]));
+    __m256i g = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[6]));
+    __m256i h = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[7]));
+    
+    for (int i = 0; i < 64; ++i) {
+        if (i >= 16) {
+            __m256i w15 = w[(i - 15) & 15];
+            __m256i w2 = w[(i - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8x(w15, 7), rotr8x(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8x(w2, 17), rotr8x(w2, 19)), _mm256_srli_epi32(w2, 10));
+            w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0), _mm256_add_epi32(w[(i - 7) & 15], s1));
+        }
+        
+        __m256i bigSigma1 = _mm256_xor_si256(_mm256_xor_si256(rotr8x(e, 6), rotr8x(e, 11)), rotr8x(e, 25));
+        __m256i choose = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, bigSigma1),
+                                      _mm256_add_epi32(choose, _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(K[i])), w[i & 15])));
+        __m256i bigSigma0 = _mm256_xor_si256(_mm256_xor_si256(rotr8x(a, 2), rotr8x(a, 13)), rotr8x(a, 22));
+        __m256i majority = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        __m256i t2 = _mm256_add_epi32(bigSigma0, majority);
+        
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+    
+    __m256i* out = reinterpret_cast<__m256i*>(state);
+    out[0] = _mm256_add_epi32(out[0], a);
+    out[1] = _mm256_add_epi32(out[1], b);
+    out[2] = _mm256_add_epi32(out[2], c);
+    out[3] = _mm256_add_epi32(out[3], d);
+    out[4] = _mm256_add_epi32(out[4], e);
+    out[5] = _mm256_add_epi32(out[5], f);
+    out[6] = _mm256_add_epi32(out[6], g);
+    out[7] = _mm256_add_epi32(out[7], h);
+}
+
+// One block for each of 16 independent messages; AVX-512 has native rotates
+// and ternary logic for Ch/Maj
+__attribute__((target("avx512f")))
+static void compressLanesAvx512(uint32_t state[8][16], const uint8_t* const blocks[16]) {
+    alignas(64) uint32_t words[16][16];
+    gatherWords<16>(words, blocks);
+    
+    __m512i w[16];
+    for (int j = 0; j < 16; ++j) {
+        w[j] = _mm512_load_si512(words[j]);
+    }
+    
+    __m512i a = _mm512_load_si512(state[0]);
+    __m512i b = _mm512_load_si512(state[1]);
+    __m512i c = _mm512_load_si512(state[2]);
+    __m512i d = _mm512_load_si512(state[3]);
+    __m512i e = _mm512_load_si512(state[4]);
+    __m512i f = _mm512_load_si512(state[5]);
+    __m512i g = _mm512_load_si512(state[6]);
+    __m512i h = _mm512_load_si512(state[7]);
+    
+    for (int i = 0; i < 64; ++i) {
+        if (i >= 16) {
+            __m512i w15 = w[(i - 15) & 15];
+            __m512i w2 = w[(i - 2) & 15];
+            __m512i s0 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(w15, 7), _mm512_ror_epi32(w15, 18), _mm512_srli_epi32(w15, 3), 0x96);
+            __m512i s1 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(w2, 17), _mm512_ror_epi32(w2, 19), _mm512_srli_epi32(w2, 10), 0x96);
+            w[i & 15] = _mm512_add_epi32(_mm512_add_epi32(w[i & 15], s0), _mm512_add_epi32(w[(i - 7) & 15], s1));
+        }
+        
+        __m512i bigSigma1 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(e, 6), _mm512_ror_epi32(e, 11), _mm512_ror_epi32(e, 25), 0x96);
+        __m512i choose = _mm512_ternarylogic_epi32(e, f, g, 0xCA);
+        __m512i t1 = _mm512_add_epi32(_mm512_add_epi32(h, bigSigma1),
+                                      _mm512_add_epi32(choose, _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(K[i])), w[i & 15])));
+        __m512i bigSigma0 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(a, 2), _mm512_ror_epi32(a, 13), _mm512_ror_epi32(a, 22), 0x96);
+        __m512i majority = _mm512_ternarylogic_epi32(a, b, c, 0xE8);
+        __m512i t2 = _mm512_add_epi32(bigSigma0, majority);
+        
+        h = g;
+        g = f;
+        f = e;
+        e = _mm512_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm512_add_epi32(t1, t2);
+    }
+    
+    _mm512_store_si512(state[0], _mm512_add_epi32(_mm512_load_si512(state[0]), a));
+    _mm512_store_si512(state[1], _mm512_add_epi32(_mm512_load_si512(state[1]), b));
+    _mm512_store_si512(state[2], _mm512_add_epi32(_mm512_load_si512(state[2]), c));
+    _mm512_store_si512(state[3], _mm512_add_epi32(_mm512_load_si512(state[3]), d));
+    _mm512_store_si512(state[4], _mm512_add_epi32(_mm512_load_si512(state[4]), e));
+    _mm512_store_si512(state[5], _mm512_add_epi32(_mm512_load_si512(state[5]), f));
+    _mm512_store_si512(state[6], _mm512_add_epi32(_mm512_load_si512(state[6]), g));
+    _mm512_store_si512(state[7], _mm512_add_epi32(_mm512_load_si512(state[7]), h));
+}
+
+static bool cpuSupportsAvx512() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & bit_OSXSAVE) == 0) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || (ebx & bit_AVX512F) == 0) {
+        return false;
+    }
+    // The OS must save the opmask and ZMM registers on context switch
+    unsigned int xcr0Low, xcr0High;
+    __asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    return (xcr0Low & 0xe6) == 0xe6;
+}
+
+static bool cpuSupportsAvx2() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & bit_OSXSAVE) == 0 || (ecx & bit_AVX) == 0) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || (ebx & bit_AVX2) == 0) {
+        return false;
+    }
+    // The OS must save the YMM registers on context switch
+    unsigned int xcr0Low, xcr0High;
+    __asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    return (xcr0Low & 0x6) == 0x6;
+}
+
+static bool cpuSupports(Sha256Backend backend) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    bool ssse3 = (ecx & bit_SSSE3) != 0;
+    bool sse41 = (ecx & bit_SSE4_1) != 0;
+    
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    
+    switch (backend) {
+        case Sha256Backend::SHA_NI:
+            return ssse3 && sse41 && (ebx & bit_SHA) != 0;
+        default:
+            return true;
+    }
+}
+
+#else
+
+// Non-x86 builds only have the scalar kernel
+void sha256CompressShaNi(uint32_t state[8], const uint8_t* blocks, size_t blockCount) {
+    sha256CompressScalar(state, blocks, blockCount);
+}
+
+static bool cpuSupports(Sha256Backend backend) {
+    return backend == Sha256Backend::SCALAR;
+}
+
+static bool cpuSupportsAvx2() {
+    return false;
+}
+
+static bool cpuSupportsAvx512() {
+    return false;
+}
+
+#endif
+
+using CompressFunction = void (*)(uint32_t*, const uint8_t*, size_t);
+
+static CompressFunction kernelFor(Sha256Backend backend) {
+    switch (backend) {
+        case Sha256Backend::SHA_NI:
+            return sha256CompressShaNi;
+        default:
+            return sha256CompressScalar;
+    }
+}
+
+// Cross-check a kernel against the scalar reference before trusting it
+static bool kernelMatchesReference(Sha256Backend backend) {
+    uint8_t message[Sha256::BLOCK_SIZE * 3];
+    for (size_t i = 0; i < sizeof(message); ++i) {
+        message[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    
+    uint32_t expected[8];
+    uint32_t actual[8];
+    std::memcpy(expected, H0, sizeof(expected));
+    std::memcpy(actual, H0, sizeof(actual));
+    
+    sha256CompressScalar(expected, message, 3);
+    kernelFor(backend)(actual, message, 3);
+    
+    return std::memcmp(expected, actual, sizeof(expected)) == 0;
+}
+
+bool sha256BackendSupported(Sha256Backend backend) {
+    return cpuSupports(backend);
+}
+
+static Sha256Backend detectBackend() {
+    if (cpuSupports(Sha256Backend::SHA_NI) && kernelMatchesReference(Sha256Backend::SHA_NI)) {
+        return Sha256Backend::SHA_NI;
+    }
+    return Sha256Backend::SCALAR;
+}
+
+// Chosen once on first use; sha256SetBackend can override it later
+struct KernelSelection {
+    KernelSelection() {
+        Sha256Backend detected = detectBackend();
+        backend.store(detected);
+        kernel.store(kernelFor(detected));
+    }
+    
+    std::atomic<Sha256Backend> backend;
+    std::atomic<CompressFunction> kernel;
+};
+
+static KernelSelection& kernelSelection() {
+    static KernelSelection selection;
+    return selection;
+}
+
+void sha256Compress(uint32_t state[8], const uint8_t* blocks, size_t blockCount) {
+    kernelSelection().kernel.load(std::memory_order_relaxed)(state, blocks, blockCount);
+}
+
+Sha256Backend sha256GetBackend() {
+    return kernelSelection().backend.load();
+}
+
+bool sha256SetBackend(Sha256Backend backend) {
+    if (!cpuSupports(backend)) {
+        return false;
+    }
+    kernelSelection().backend.store(backend);
+    kernelSelection().kernel.store(kernelFor(backend));
+    return true;
+}
+
+const char* sha256BackendName(Sha256Backend backend) {
+    switch (backend) {
+        case Sha256Backend::SHA_NI:
+            return "sha-ni";
+        default:
+            return "scalar";
+    }
+}
+
+Sha256::Sha256() {
+    init();
+}
+
+void Sha256::init() {
+    std::memcpy(m_state, H0, sizeof(m_state));
+    m_bufferLength = 0;
+    m_totalLength = 0;
+}
+
+void Sha256::update(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    m_totalLength += length;
+
+    // Top up a partially filled block first
+    if (m_bufferLength > 0) {
+        size_t take = std::min(length, BLOCK_SIZE - m_bufferLength);
+        std::memcpy(m_buffer + m_bufferLength, bytes, take);
+        m_bufferLength += take;
+        bytes += take;
+        length -= take;
+
+        if (m_bufferLength < BLOCK_SIZE) {
+            return;
+        }
+
+        sha256Compress(m_state, m_buffer, 1);
+        m_bufferLength = 0;
+    }
+
+    // Compress whole blocks straight from the caller's memory
+    size_t blockCount = length / BLOCK_SIZE;
+    if (blockCount > 0) {
+        sha256Compress(m_state, bytes, blockCount);
+        bytes += blockCount * BLOCK_SIZE;
+        length -= blockCount * BLOCK_SIZE;
+    }
+
+    // Keep the tail for the next call
+    if (length > 0) {
+        std::memcpy(m_buffer, bytes, length);
+        m_bufferLength = length;
+    }
+}
+
+void Sha256::updateUint32(uint32_t value) {
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = (value >> (i * 8)) & 0xff;
+    }
+    update(bytes, sizeof(bytes));
+}
+
+void Sha256::updateUint64(uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = (value >> (i * 8)) & 0xff;
+    }
+    update(bytes, sizeof(bytes));
+}
+
+void Sha256::updateString(const std::string& data) {
+    updateUint32(static_cast<uint32_t>(data.size()));
+    update(data.data(), data.size());
+}
+
+Hash256 Sha256::final() {
+    uint64_t bitLength = m_totalLength * 8;
+
+    // Append the bit '1' (0x80) after the message
+    m_buffer[m_bufferLength++] = 0x80;
+
+    // If there is no room for the length, pad out this block and start another
+    if (m_bufferLength > BLOCK_SIZE - 8) {
+        std::memset(m_buffer + m_bufferLength, 0, BLOCK_SIZE - m_bufferLength);
+        sha256Compress(m_state, m_buffer, 1);
+        m_bufferLength = 0;
+    }
+
+    // Zero-fill, then the message length in bits as a 64-bit big-endian integer
+    std::memset(m_buffer + m_bufferLength, 0, BLOCK_SIZE - 8 - m_bufferLength);
+    for (int i = 0; i < 8; ++i) {
+        m_buffer[BLOCK_SIZE - 8 + i] = (bitLength >> (56 - i * 8)) & 0xff;
+    }
+    sha256Compress(m_state, m_buffer, 1);
+
+    // Produce the final hash value as a 256-bit big-endian number
+    Hash256 digest;
+    uint8_t* out = digest.data();
+    for (int i = 0; i < 8; ++i) {
+        out[i * 4] = (m_state[i] >> 24) & 0xff;
+        out[i * 4 + 1] = (m_state[i] >> 16) & 0xff;
+        out[i * 4 + 2] = (m_state[i] >> 8) & 0xff;
+        out[i * 4 + 3] = m_state[i] & 0xff;
+    }
+
+    return digest;
+}
+
+void HashPreimage::updateUint32(uint32_t value) {
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = (value >> (i * 8)) & 0xff;
+    }
+    update(bytes, sizeof(bytes));
+}
+
+void HashPreimage::updateUint64(uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = (value >> (i * 8)) & 0xff;
+    }
+    update(bytes, sizeof(bytes));
+}
+
+void HashPreimage::updateString(const std::string& data) {
+    updateUint32(static_cast<uint32_t>(data.size()));
+    update(data.data(), data.size());
+}
+
+// A message as seen by one SIMD lane: whole blocks are read in place, the
+// padded tail (one or two blocks) is staged locally
+struct BatchLane {
+    const uint8_t* data;
+    size_t fullBlocks;
+    size_t blockCount;
+    uint8_t tail[Sha256::BLOCK_SIZE * 2];
+    
+    // prefixLength counts bytes already absorbed into the starting state
+    void prepare(const uint8_t* message, size_t length, uint64_t prefixLength) {
+        data = message;
+        fullBlocks = length / Sha256::BLOCK_SIZE;
+        
+        size_t remainder = length % Sha256::BLOCK_SIZE;
+        size_t tailBlocks = (remainder + 9 <= Sha256::BLOCK_SIZE) ? 1 : 2;
+        blockCount = fullBlocks + tailBlocks;
+        
+        std::memset(tail, 0, sizeof(tail));
+        if (remainder > 0) {
+            std::memcpy(tail, message + fullBlocks * Sha256::BLOCK_SIZE, remainder);
+        }
+        tail[remainder] = 0x80;
+        
+        uint64_t bitLength = (prefixLength + length) * 8;
+        uint8_t* lengthField = tail + tailBlocks * Sha256::BLOCK_SIZE - 8;
+        for (int i = 0; i < 8; ++i) {
+            lengthField[i] = (bitLength >> (56 - i * 8)) & 0xff;
+        }
+    }
+    
+    const uint8_t* block(size_t index) const {
+        if (index < fullBlocks) {
+            return data + index * Sha256::BLOCK_SIZE;
+        }
+        return tail + (index - fullBlocks) * Sha256::BLOCK_SIZE;
+    }
+};
+
+static void storeDigest(const uint32_t state[8], Hash256& digest) {
+    uint8_t* out = digest.data();
+    for (int j = 0; j < 8; ++j) {
+        out[j * 4] = (state[j] >> 24) & 0xff;
+        out[j * 4 + 1] = (state[j] >> 16) & 0xff;
+        out[j * 4 + 2] = (state[j] >> 8) & 0xff;
+        out[j * 4 + 3] = state[j] & 0xff;
+    }
+}
+
+// Finish one message from a starting state with the active single-buffer backend
+static void hashFromState(const uint32_t initialState[8], uint64_t prefixLength,
+                          const uint8_t* message, size_t length, Hash256& digest) {
+    BatchLane lane;
+    lane.prepare(message, length, prefixLength);
+    
+    uint32_t state[8];
+    std::memcpy(state, initialState, sizeof(state));
+    if (lane.fullBlocks > 0) {
+        sha256Compress(state, lane.data, lane.fullBlocks);
+    }
+    sha256Compress(state, lane.tail, lane.blockCount - lane.fullBlocks);
+    
+    storeDigest(state, digest);
+}
+
+template <size_t LANES>
+using LaneKernel = void (*)(uint32_t state[8][LANES], const uint8_t* const blocks[LANES]);
+
+// Hash LANES messages at a time; lanes that finish early keep running on a
+// zero block and their result is simply not read again
+template <size_t LANES>
+static void batchWithLanes(LaneKernel<LANES> kernel, const uint32_t initialState[8], uint64_t prefixLength,
+                           const uint8_t* const* messages, const size_t* lengths,
+                           Hash256* digests, size_t count) {
+    static const uint8_t zeroBlock[Sha256::BLOCK_SIZE] = {};
+    
+    for (size_t start = 0; start < count; start += LANES) {
+        size_t active = std::min(LANES, count - start);
+        if (active == 1) {
+            hashFromState(initialState, prefixLength, messages[start], lengths[start], digests[start]);
+            continue;
+        }
+        
+        BatchLane lanes[LANES];
+        alignas(64) uint32_t state[8][LANES];
+        size_t maxBlocks = 0;
+        
+        for (int j = 0; j < 8; ++j) {
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                state[j][lane] = initialState[j];
+            }
+        }
+        for (size_t lane = 0; lane < active; ++lane) {
+            lanes[lane].prepare(messages[start + lane], lengths[start + lane], prefixLength);
+            maxBlocks = std::max(maxBlocks, lanes[lane].blockCount);
+        }
+        
+        const uint8_t* blockPointers[LANES];
+        for (size_t step = 0; step < maxBlocks; ++step) {
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                bool live = lane < active && step < lanes[lane].blockCount;
+                blockPointers[lane] = live ? lanes[lane].block(step) : zeroBlock;
+            }
+            
+            kernel(state, blockPointers);
+            
+            for (size_t lane = 0; lane < active; ++lane) {
+                if (step + 1 != lanes[lane].blockCount) {
+                    continue;
+                }
+                uint8_t* out = digests[start + lane].data();
+                for (int j = 0; j < 8; ++j) {
+                    out[j * 4] = (state[j][lane] >> 24) & 0xff;
+                    out[j * 4 + 1] = (state[j][lane] >> 16) & 0xff;
+                    out[j * 4 + 2] = (state[j][lane] >> 8) & 0xff;
+                    out[j * 4 + 3] = state[j][lane] & 0xff;
+                }
+            }
+        }
+    }
+}
+
+static void batchSequential(const uint32_t initialState[8], uint64_t prefixLength,
+                            const uint8_t* const* messages, const size_t* lengths,
+                            Hash256* digests, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        hashFromState(initialState, prefixLength, messages[i], lengths[i], digests[i]);
+    }
+}
+
+static void runBatch(size_t lanes, const uint32_t initialState[8], uint64_t prefixLength,
+                     const uint8_t* const* messages, const size_t* lengths,
+                     Hash256* digests, size_t count) {
+#if AHMIYAT_SHA256_X86
+    if (lanes == 16) {
+        batchWithLanes<16>(compressLanesAvx512, initialState, prefixLength, messages, lengths, digests, count);
+        return;
+    }
+    if (lanes == 8) {
+        batchWithLanes<8>(compressLanesAvx2, initialState, prefixLength, messages, lengths, digests, count);
+        return;
+    }
+#endif
+    batchSequential(initialState, prefixLength, messages, lengths, digests, count);
+}
+
+// Cross-check a lane width against the single-buffer path before using it
+static bool batchMatchesReference(size_t lanes) {
+    std::vector<std::string> messages;
+    for (size_t i = 0; i < lanes + 3; ++i) {
+        messages.push_back(std::string(i * 29 % 150, static_cast<char>('a' + i)));
+    }
+    
+    std::vector<const uint8_t*> pointers;
+    std::vector<size_t> lengths;
+    for (const auto& message : messages) {
+        pointers.push_back(reinterpret_cast<const uint8_t*>(message.data()));
+        lengths.push_back(message.size());
+    }
+    
+    std::vector<Hash256> expected(messages.size());
+    std::vector<Hash256> actual(messages.size());
+    for (size_t i = 0; i < messages.size(); ++i) {
+        Sha256 ctx;
+        ctx.update(messages[i]);
+        expected[i] = ctx.final();
+    }
+    runBatch(lanes, H0, 0, pointers.data(), lengths.data(), actual.data(), messages.size());
+    
+    return expected == actual;
+}
+
+static size_t detectBatchLanes() {
+    if (cpuSupportsAvx512() && batchMatchesReference(16)) {
+        return 16;
+    }
+    if (cpuSupportsAvx2() && batchMatchesReference(8)) {
+        return 8;
+    }
+    return 1;
+}
+
+// Chosen once on first use; sha256SetBatchLanes can override it later
+static std::atomic<size_t>& batchLaneSelection() {
+    static std::atomic<size_t> lanes(detectBatchLanes());
+    return lanes;
+}
+
+size_t sha256BatchLanes() {
+    return batchLaneSelection().load(std::memory_order_relaxed);
+}
+
+bool sha256SetBatchLanes(size_t lanes) {
+    bool supported = lanes == 1 || (lanes == 8 && cpuSupportsAvx2()) || (lanes == 16 && cpuSupportsAvx512());
+    if (!supported) {
+        return false;
+    }
+    batchLaneSelection().store(lanes);
+    return true;
+}
+
+void sha256Batch(const uint8_t* const* messages, const size_t* lengths, Hash256* digests, size_t count) {
+    runBatch(sha256BatchLanes(), H0, 0, messages, lengths, digests, count);
+}
+
+std::vector<Hash256> sha256Batch(const std::vector<std::string>& messages) {
+    std::vector<const uint8_t*> pointers;
+    std::vector<size_t> lengths;
+    pointers.reserve(messages.size());
+    lengths.reserve(messages.size());
+    
+    for (const auto& message : messages) {
+        pointers.push_back(reinterpret_cast<const uint8_t*>(message.data()));
+        lengths.push_back(message.size());
+    }
+    
+    std::vector<Hash256> digests(messages.size());
+    sha256Batch(pointers.data(), lengths.data(), digests.data(), messages.size());
+    return digests;
+}
+
+Sha256Midstate::Sha256Midstate(const void* prefix, size_t length) : m_prefixLength(length) {
+    if (length % Sha256::BLOCK_SIZE != 0) {
+        throw std::invalid_argument("Midstate prefix must be a whole number of 64-byte blocks");
+    }
+    
+    std::memcpy(m_state, H0, sizeof(m_state));
+    if (length > 0) {
+        sha256Compress(m_state, static_cast<const uint8_t*>(prefix), length / Sha256::BLOCK_SIZE);
+    }
+}
+
+Hash256 Sha256Midstate::finish(const void* tail, size_t length) const {
+    Hash256 digest;
+    hashFromState(m_state, m_prefixLength, static_cast<const uint8_t*>(tail), length, digest);
+    return digest;
+}
+
+void Sha256Midstate::finishBatch(const uint8_t* const* tails, const size_t* lengths,
+                                 Hash256* digests, size_t count) const {
+    runBatch(sha256BatchLanes(), m_state, m_prefixLength, tails, lengths, digests, count);
+}
+
+} // namespace utils
+} // namespace ahmiyat
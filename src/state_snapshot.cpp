@@ -0,0 +1,182 @@
+#include "../include/state_snapshot.h"
+#include "../include/binary_io.h"
+#include "../include/file_mapping.h"
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sys/stat.h>
+
+namespace {
+
+// Magic, version, payload length, payload CRC
+constexpr size_t FILE_HEADER_SIZE = 20;
+
+void writePayload(const StateSnapshot& snapshot, ahmiyat::utils::BinaryWriter& writer) {
+    writer.writeUint64(snapshot.height);
+    writer.writeHash(snapshot.tipHash);
+
+    writer.writeUint64(snapshot.balances.size());
+    for (const auto& entry : snapshot.balances) {
+        writer.writeString(entry.first);
+        writer.writeDouble(entry.second);
+    }
+
+    writer.writeUint64(snapshot.addressHistory.size());
+    for (const auto& entry : snapshot.addressHistory) {
+        writer.writeString(entry.first);
+        writer.writeUint32(static_cast<uint32_t>(entry.second.size()));
+        for (const auto& location : entry.second) {
+            writer.writeUint32(location.blockIndex);
+            writer.writeUint32(location.txOffset);
+        }
+    }
+
+    writer.writeUint64(snapshot.memoryProofs.size());
+    for (const auto& entry : snapshot.memoryProofs) {
+        const std::vector<Hash256>& hashes = snapshot.memoryProofHashes.at(entry.first);
+        writer.writeString(entry.first);
+        writer.writeUint32(static_cast<uint32_t>(entry.second.size()));
+        for (size_t i = 0; i < entry.second.size(); ++i) {
+            entry.second[i].serialize(writer);
+            writer.writeHash(hashes[i]);
+        }
+    }
+}
+
+bool readPayload(ahmiyat::utils::BinaryReader& reader, StateSnapshot& snapshot) {
+    reader.readUint64(snapshot.height);
+    reader.readHash(snapshot.tipHash);
+
+    // Counts come from the file, so each is checked against the bytes left
+    // before anything is reserved for it
+    uint64_t count = 0;
+    if (!reader.readUint64(count) || count > reader.remaining()) {
+        return false;
+    }
+    snapshot.balances.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string address;
+        double balance = 0.0;
+        if (!reader.readString(address) || !reader.readDouble(balance)) {
+            return false;
+        }
+        snapshot.balances.emplace(std::move(address), balance);
+    }
+
+    if (!reader.readUint64(count) || count > reader.remaining()) {
+        return false;
+    }
+    snapshot.addressHistory.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string address;
+        uint32_t locationCount = 0;
+        if (!reader.readString(address) || !reader.readUint32(locationCount) ||
+            locationCount > reader.remaining() / 8) {
+            return false;
+        }
+        std::vector<TransactionLocation>& locations = snapshot.addressHistory[address];
+        locations.resize(locationCount);
+        for (auto& location : locations) {
+            reader.readUint32(location.blockIndex);
+            reader.readUint32(location.txOffset);
+        }
+    }
+
+    if (!reader.readUint64(count) || count > reader.remaining()) {
+        return false;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string uploader;
+        uint32_t proofCount = 0;
+        if (!reader.readString(uploader) || !reader.readUint32(proofCount) || proofCount > reader.remaining()) {
+            return false;
+        }
+        std::vector<MemoryProof>& proofs = snapshot.memoryProofs[uploader];
+        std::vector<Hash256>& hashes = snapshot.memoryProofHashes[uploader];
+        proofs.resize(proofCount);
+        hashes.resize(proofCount);
+        for (uint32_t j = 0; j < proofCount; ++j) {
+            if (!MemoryProof::deserialize(reader, proofs[j]) || !reader.readHash(hashes[j])) {
+                return false;
+            }
+        }
+    }
+
+    return !reader.failed() && reader.remaining() == 0;
+}
+
+} // namespace
+
+bool StateSnapshot::save(const std::string& filename) const {
+    ahmiyat::utils::BinaryWriter payload;
+    writePayload(*this, payload);
+
+    ahmiyat::utils::BinaryWriter header;
+    header.writeUint32(MAGIC);
+    header.writeUint32(VERSION);
+    header.writeUint64(payload.size());
+    header.writeUint32(ahmiyat::utils::crc32(payload.bytes().data(), payload.size()));
+
+    // Write and flush beside the old snapshot, then rename over it
+    std::string tempFilename = filename + ".tmp";
+    {
+        ahmiyat::utils::FileDescriptor file(tempFilename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC);
+        if (file.fd < 0 || !ahmiyat::utils::writeAll(file.fd, header.bytes().data(), header.size()) ||
+            !ahmiyat::utils::writeAll(file.fd, payload.bytes().data(), payload.size()) ||
+            ::fdatasync(file.fd) != 0) {
+            std::cerr << "Failed to write state snapshot" << std::endl;
+            return false;
+        }
+    }
+
+    std::string directory = std::filesystem::path(filename).parent_path().string();
+    if (std::rename(tempFilename.c_str(), filename.c_str()) != 0 ||
+        !ahmiyat::utils::syncDirectory(directory.empty() ? "." : directory)) {
+        std::cerr << "Failed to replace state snapshot" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool StateSnapshot::load(const std::string& filename, StateSnapshot& snapshot) {
+    ahmiyat::utils::FileDescriptor file(filename);
+    struct stat st;
+    if (file.fd < 0 || ::fstat(file.fd, &st) != 0) {
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    ahmiyat::utils::FileMapping mapping(file.fd, fileSize, MADV_SEQUENTIAL);
+    if (!mapping.valid() || fileSize < FILE_HEADER_SIZE) {
+        std::cerr << "Invalid state snapshot file" << std::endl;
+        return false;
+    }
+
+    ahmiyat::utils::BinaryReader header(mapping.bytes(), FILE_HEADER_SIZE);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t length = 0;
+    uint32_t crc = 0;
+    header.readUint32(magic);
+    header.readUint32(version);
+    header.readUint64(length);
+    header.readUint32(crc);
+
+    const uint8_t* payload = mapping.bytes() + FILE_HEADER_SIZE;
+    if (magic != MAGIC || version != VERSION || length != fileSize - FILE_HEADER_SIZE ||
+        ahmiyat::utils::crc32(payload, length) != crc) {
+        std::cerr << "Invalid state snapshot file" << std::endl;
+        return false;
+    }
+
+    StateSnapshot loaded;
+    ahmiyat::utils::BinaryReader reader(payload, length);
+    if (!readPayload(reader, loaded)) {
+        std::cerr << "Invalid state snapshot file" << std::endl;
+        return false;
+    }
+
+    snapshot = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,154 @@
+#include "../include/target.h"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace ahmiyat {
+namespace utils {
+
+bool compactToTarget(uint32_t bits, Hash256& target) {
+    uint32_t size = bits >> 24;
+    uint32_t mantissa = bits & 0x00ffffff;
+
+    if (mantissa == 0 || size == 0 || size > Hash256::SIZE) {
+        return false;
+    }
+
+    Hash256 result;
+    uint8_t* out = result.data();
+
+    // The mantissa starts size bytes from the least significant end; for
+    // sizes below three its low bytes fall off the end and are dropped
+    for (uint32_t i = 0; i < 3; ++i) {
+        uint8_t byte = static_cast<uint8_t>((mantissa >> (8 * (2 - i))) & 0xff);
+        size_t position = Hash256::SIZE - size + i;
+        if (position < Hash256::SIZE) {
+            out[position] = byte;
+        }
+    }
+
+    if (result.isZero()) {
+        return false;
+    }
+
+    target = result;
+    return true;
+}
+
+uint32_t targetToCompact(const Hash256& target) {
+    const uint8_t* bytes = target.data();
+
+    size_t first = 0;
+    while (first < Hash256::SIZE && bytes[first] == 0) {
+        ++first;
+    }
+    if (first == Hash256::SIZE) {
+        return 0;
+    }
+
+    uint32_t size = static_cast<uint32_t>(Hash256::SIZE - first);
+    uint32_t mantissa = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        size_t position = first + i;
+        uint8_t byte = position < Hash256::SIZE ? bytes[position] : 0;
+        mantissa = (mantissa << 8) | byte;
+    }
+
+    return (size << 24) | mantissa;
+}
+
+namespace {
+
+// 256-bit numbers as 32-bit limbs, least significant first, with one spare
+// limb to catch overflow
+constexpr size_t LIMBS = Hash256::SIZE / 4;
+using Limbs = std::array<uint64_t, LIMBS + 1>;
+
+Limbs toLimbs(const Hash256& value) {
+    Limbs limbs{};
+    const uint8_t* bytes = value.data();
+    for (size_t i = 0; i < LIMBS; ++i) {
+        const uint8_t* word = bytes + Hash256::SIZE - 4 * (i + 1);
+        limbs[i] = (static_cast<uint64_t>(word[0]) << 24) | (static_cast<uint64_t>(word[1]) << 16) |
+                   (static_cast<uint64_t>(word[2]) << 8) | word[3];
+    }
+    return limbs;
+}
+
+// Propagate carries so every limb holds 32 bits
+void normalize(Limbs& limbs) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < limbs.size(); ++i) {
+        uint64_t value = limbs[i] + carry;
+        limbs[i] = value & 0xffffffff;
+        carry = value >> 32;
+    }
+}
+
+void divide(Limbs& limbs, uint64_t denominator) {
+    uint64_t remainder = 0;
+    for (size_t i = limbs.size(); i-- > 0;) {
+        uint64_t value = (remainder << 32) | limbs[i];
+        limbs[i] = value / denominator;
+        remainder = value % denominator;
+    }
+}
+
+// Back to 256 bits, saturating to all ones on overflow
+Hash256 fromLimbs(const Limbs& limbs) {
+    Hash256 result;
+    uint8_t* out = result.data();
+
+    if (limbs[LIMBS] != 0) {
+        std::memset(out, 0xff, Hash256::SIZE);
+        return result;
+    }
+
+    for (size_t i = 0; i < LIMBS; ++i) {
+        uint8_t* word = out + Hash256::SIZE - 4 * (i + 1);
+        word[0] = static_cast<uint8_t>(limbs[i] >> 24);
+        word[1] = static_cast<uint8_t>(limbs[i] >> 16);
+        word[2] = static_cast<uint8_t>(limbs[i] >> 8);
+        word[3] = static_cast<uint8_t>(limbs[i]);
+    }
+    return result;
+}
+
+} // namespace
+
+Hash256 scaleTarget(const Hash256& target, uint32_t numerator, uint32_t denominator) {
+    if (denominator == 0) {
+        throw std::invalid_argument("Target scale denominator cannot be zero");
+    }
+
+    Limbs limbs = toLimbs(target);
+    for (auto& limb : limbs) {
+        limb *= numerator;
+    }
+    normalize(limbs);
+    divide(limbs, denominator);
+
+    return fromLimbs(limbs);
+}
+
+Hash256 averageTargets(const std::vector<Hash256>& targets) {
+    if (targets.empty()) {
+        return Hash256();
+    }
+
+    // Limbs are summed before carrying; 64-bit limbs hold 2^32 such sums
+    Limbs sum{};
+    for (const auto& target : targets) {
+        Limbs limbs = toLimbs(target);
+        for (size_t i = 0; i < LIMBS; ++i) {
+            sum[i] += limbs[i];
+        }
+    }
+    normalize(sum);
+    divide(sum, targets.size());
+
+    return fromLimbs(sum);
+}
+
+} // namespace utils
+} // namespace ahmiyat
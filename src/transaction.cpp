@@ -1,9 +1,11 @@
 #include "../include/transaction.h"
 #include "../include/utils.h"
+#include "../include/sha256.h"
 #include <sstream>
 #include <stdexcept>
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 
 // Constructor for coin transfer
 Transaction::Transaction(const std::string& fromAddress, const std::string& toAddress, double amount)
@@ -53,8 +55,8 @@ void Transaction::signTransaction(const std::string& privateKey) {
         }
         
         // Calculate the hash and sign it with the private key
-        std::string txHash = calculateHash();
-        m_signature = ahmiyat::utils::sign(privateKey, txHash);
+        Hash256 txHash = calculateHash();
+        m_signature = ahmiyat::utils::sign(privateKey, txHash.toHex());
     }
 }
 
@@ -73,20 +75,38 @@ bool Transaction::isValid() const {
         throw std::invalid_argument("Cannot validate unsigned transaction");
     }
     
-    return ahmiyat::utils::verify(m_fromAddress, m_signature, calculateHash());
+    return ahmiyat::utils::verify(m_fromAddress, m_signature, calculateHash().toHex());
 }
 
-std::string Transaction::calculateHash() const {
-    std::stringstream ss;
-    ss << m_fromAddress << m_toAddress << m_amount << m_timestamp;
+template <typename Sink>
+void Transaction::writeHashFields(Sink& sink) const {
+    sink.updateString(m_fromAddress);
+    sink.updateString(m_toAddress);
+    
+    // Hash the exact IEEE-754 bits of the amount
+    uint64_t amountBits;
+    std::memcpy(&amountBits, &m_amount, sizeof(amountBits));
+    sink.updateUint64(amountBits);
+    sink.updateUint64(static_cast<uint64_t>(m_timestamp));
     
     if (m_type == TransactionType::MEMORY_REWARD) {
-        ss << "MEMORY_REWARD" << m_memoryProofHash;
+        sink.updateString("MEMORY_REWARD");
+        sink.updateString(m_memoryProofHash);
     } else {
-        ss << "COIN_TRANSFER";
+        sink.updateString("COIN_TRANSFER");
     }
-    
-    return ahmiyat::utils::sha256(ss.str());
+}
+
+Hash256 Transaction::calculateHash() const {
+    ahmiyat::utils::Sha256 ctx;
+    writeHashFields(ctx);
+    return ctx.final();
+}
+
+std::string Transaction::hashPreimage() const {
+    ahmiyat::utils::HashPreimage preimage;
+    writeHashFields(preimage);
+    return std::move(preimage.bytes());
 }
 
 std::string Transaction::getFromAddress() const {
@@ -187,3 +207,34 @@ Transaction Transaction::fromJson(const std::string& json) {
         return dummy;
     }
 }
+
+void Transaction::serialize(ahmiyat::utils::BinaryWriter& writer) const {
+    writer.writeString(m_fromAddress);
+    writer.writeString(m_toAddress);
+    writer.writeDouble(m_amount);
+    writer.writeUint64(static_cast<uint64_t>(m_timestamp));
+    writer.writeUint8(static_cast<uint8_t>(m_type));
+    writer.writeString(m_signature);
+    writer.writeString(m_memoryProofHash);
+}
+
+bool Transaction::deserialize(ahmiyat::utils::BinaryReader& reader, Transaction& transaction) {
+    uint64_t timestamp = 0;
+    uint8_t type = 0;
+    
+    reader.readString(transaction.m_fromAddress);
+    reader.readString(transaction.m_toAddress);
+    reader.readDouble(transaction.m_amount);
+    reader.readUint64(timestamp);
+    reader.readUint8(type);
+    reader.readString(transaction.m_signature);
+    reader.readString(transaction.m_memoryProofHash);
+    
+    if (reader.failed() || type > static_cast<uint8_t>(TransactionType::MEMORY_REWARD)) {
+        return false;
+    }
+    
+    transaction.m_timestamp = static_cast<time_t>(timestamp);
+    transaction.m_type = static_cast<TransactionType>(type);
+    return true;
+}
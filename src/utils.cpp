@@ -1,4 +1,7 @@
 #include "../include/utils.h"
+#include "../include/sha256.h"
+#include "../include/thread_pool.h"
+#include "../include/file_mapping.h"
 #include <fstream>
 #include <sstream>
 #include <iomanip>
@@ -11,349 +14,273 @@
 #include <chrono>
 #include <array>
 #include <functional>
+#include <memory>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace ahmiyat {
 namespace utils {
 
-// SHA-256 Constants (first 32 bits of the fractional parts of the cube roots of the first 64 primes)
-static constexpr std::array<uint32_t, 64> K = {
-    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
-    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
-    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
-    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
-    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
-    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
-    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
-    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
-    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-};
+namespace {
 
-// Rotate right (circular right shift) operation
-inline uint32_t rotr(uint32_t x, uint32_t n) {
-    return (x >> n) | (x << (32 - n));
-}
+// Below this size a couple of read() calls are cheaper than setting up a mapping
+constexpr size_t MMAP_HASH_THRESHOLD = 256 * 1024;
+constexpr size_t READ_HASH_BUFFER_SIZE = 1024 * 1024;
+constexpr size_t READ_HASH_BUFFER_ALIGNMENT = 4096;
 
-// SHA-256 functions
-inline uint32_t ch(uint32_t x, uint32_t y, uint32_t z) {
-    return (x & y) ^ (~x & z);
-}
+// Domain prefixes keep tree leaves and interior nodes from colliding
+constexpr uint8_t TREE_LEAF_PREFIX = 0x00;
+constexpr uint8_t TREE_NODE_PREFIX = 0x01;
 
-inline uint32_t maj(uint32_t x, uint32_t y, uint32_t z) {
-    return (x & y) ^ (x & z) ^ (y & z);
+// Hash a file with large page-aligned read() calls
+bool hashFileReads(int fd, Sha256& ctx) {
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    
+    void* raw = nullptr;
+    if (::posix_memalign(&raw, READ_HASH_BUFFER_ALIGNMENT, READ_HASH_BUFFER_SIZE) != 0) {
+        return false;
+    }
+    std::unique_ptr<void, decltype(&std::free)> buffer(raw, &std::free);
+    
+    while (true) {
+        ssize_t bytesRead = ::read(fd, buffer.get(), READ_HASH_BUFFER_SIZE);
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (bytesRead == 0) {
+            return true;
+        }
+        ctx.update(buffer.get(), static_cast<size_t>(bytesRead));
+    }
 }
 
-inline uint32_t sigma0(uint32_t x) {
-    return rotr(x, 2) ^ rotr(x, 13) ^ rotr(x, 22);
+// Read exactly length bytes at offset
+bool readFileRange(int fd, uint8_t* out, size_t length, uint64_t offset) {
+    while (length > 0) {
+        ssize_t bytesRead = ::pread(fd, out, length, static_cast<off_t>(offset));
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (bytesRead == 0) {
+            return false;
+        }
+        out += bytesRead;
+        length -= static_cast<size_t>(bytesRead);
+        offset += static_cast<uint64_t>(bytesRead);
+    }
+    return true;
 }
 
-inline uint32_t sigma1(uint32_t x) {
-    return rotr(x, 6) ^ rotr(x, 11) ^ rotr(x, 25);
+} // namespace
+
+std::string sha256(const std::string& str) {
+    return sha256Digest(str).toHex();
 }
 
-inline uint32_t gamma0(uint32_t x) {
-    return rotr(x, 7) ^ rotr(x, 18) ^ (x >> 3);
+Hash256 sha256Digest(const std::string& str) {
+    Sha256 ctx;
+    ctx.update(str);
+    return ctx.final();
 }
 
-inline uint32_t gamma1(uint32_t x) {
-    return rotr(x, 17) ^ rotr(x, 19) ^ (x >> 10);
+std::string sha256File(const std::string& filePath) {
+    return sha256FileDigest(filePath).toHex();
 }
 
-// Custom SHA-256 implementation
-std::string sha256(const std::string& str) {
-    // Initialize hash values (first 32 bits of the fractional parts of the square roots of the first 8 primes)
-    uint32_t h0 = 0x6a09e667;
-    uint32_t h1 = 0xbb67ae85;
-    uint32_t h2 = 0x3c6ef372;
-    uint32_t h3 = 0xa54ff53a;
-    uint32_t h4 = 0x510e527f;
-    uint32_t h5 = 0x9b05688c;
-    uint32_t h6 = 0x1f83d9ab;
-    uint32_t h7 = 0x5be0cd19;
-    
-    // Pre-processing
-    size_t original_len = str.length();
-    size_t total_len = ((original_len + 8) / 64 + 1) * 64; // Ensure it's a multiple of 64 bytes
+Hash256 sha256FileDigest(const std::string& filePath) {
+    FileDescriptor file(filePath);
+    if (file.fd < 0) {
+        throw std::runtime_error("Failed to open file for hashing: " + filePath);
+    }
     
-    std::vector<uint8_t> msg(total_len, 0); // Initialize with zeros
+    Sha256 ctx;
+    bool ok = false;
+    
+    // Large regular files are hashed straight out of the page cache
+    struct stat st;
+    if (::fstat(file.fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        static_cast<size_t>(st.st_size) >= MMAP_HASH_THRESHOLD) {
+        FileMapping mapping(file.fd, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        if (mapping.valid()) {
+            ctx.update(mapping.bytes(), mapping.size);
+            ok = true;
+        }
+    }
     
-    // Copy the input string
-    memcpy(msg.data(), str.data(), original_len);
+    // Small files, special files, and mappings that failed are read instead
+    if (!ok) {
+        ok = hashFileReads(file.fd, ctx);
+    }
     
-    // Append the bit '1' (0x80) after the message
-    msg[original_len] = 0x80;
+    if (!ok) {
+        throw std::runtime_error("Failed to read file for hashing: " + filePath);
+    }
     
-    // Append the length of the message in bits as a 64-bit big-endian integer
-    uint64_t bit_len = original_len * 8;
-    for (int i = 0; i < 8; ++i) {
-        msg[total_len - 8 + i] = (bit_len >> (56 - i * 8)) & 0xff;
+    return ctx.final();
+}
+
+Hash256 sha256TreeLeaf(const void* data, size_t length) {
+    Sha256 ctx;
+    ctx.update(&TREE_LEAF_PREFIX, 1);
+    ctx.update(data, length);
+    return ctx.final();
+}
+
+Hash256 sha256TreeRoot(const std::vector<Hash256>& leaves) {
+    if (leaves.empty()) {
+        return Hash256();
     }
     
-    // Process the message in 512-bit (64-byte) chunks
-    for (size_t chunk = 0; chunk < total_len; chunk += 64) {
-        std::array<uint32_t, 64> w{};
-        
-        // Break chunk into 16 32-bit big-endian words
-        for (int i = 0; i < 16; ++i) {
-            w[i] = ((uint32_t)msg[chunk + i * 4] << 24) |
-                   ((uint32_t)msg[chunk + i * 4 + 1] << 16) |
-                   ((uint32_t)msg[chunk + i * 4 + 2] << 8) |
-                   ((uint32_t)msg[chunk + i * 4 + 3]);
-        }
+    std::vector<Hash256> level = leaves;
+    std::string nodes;
+    std::vector<const uint8_t*> messages;
+    std::vector<size_t> lengths;
+    
+    while (level.size() > 1) {
+        // Pair up nodes and hash the whole level in one batch; an odd node
+        // out is carried up unchanged rather than paired with itself
+        size_t pairs = level.size() / 2;
+        const size_t nodeSize = 1 + 2 * Hash256::SIZE;
         
-        // Extend the 16 words into 64 words
-        for (int i = 16; i < 64; ++i) {
-            w[i] = gamma1(w[i - 2]) + w[i - 7] + gamma0(w[i - 15]) + w[i - 16];
+        nodes.resize(pairs * nodeSize);
+        messages.resize(pairs);
+        lengths.assign(pairs, nodeSize);
+        for (size_t i = 0; i < pairs; ++i) {
+            char* node = &nodes[i * nodeSize];
+            node[0] = static_cast<char>(TREE_NODE_PREFIX);
+            std::memcpy(node + 1, level[2 * i].data(), Hash256::SIZE);
+            std::memcpy(node + 1 + Hash256::SIZE, level[2 * i + 1].data(), Hash256::SIZE);
+            messages[i] = reinterpret_cast<const uint8_t*>(node);
         }
         
-        // Initialize working variables
-        uint32_t a = h0;
-        uint32_t b = h1;
-        uint32_t c = h2;
-        uint32_t d = h3;
-        uint32_t e = h4;
-        uint32_t f = h5;
-        uint32_t g = h6;
-        uint32_t h = h7;
-        
-        // Main loop
-        for (int i = 0; i < 64; ++i) {
-            uint32_t t1 = h + sigma1(e) + ch(e, f, g) + K[i] + w[i];
-            uint32_t t2 = sigma0(a) + maj(a, b, c);
-            
-            h = g;
-            g = f;
-            f = e;
-            e = d + t1;
-            d = c;
-            c = b;
-            b = a;
-            a = t1 + t2;
+        std::vector<Hash256> parents((level.size() + 1) / 2);
+        sha256Batch(messages.data(), lengths.data(), parents.data(), pairs);
+        if (level.size() % 2 == 1) {
+            parents.back() = level.back();
         }
         
-        // Add the compressed chunk to the current hash value
-        h0 += a;
-        h1 += b;
-        h2 += c;
-        h3 += d;
-        h4 += e;
-        h5 += f;
-        h6 += g;
-        h7 += h;
-    }
-    
-    // Produce the final hash value as a 256-bit number (32 bytes) in hex format
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0')
-       << std::setw(8) << h0
-       << std::setw(8) << h1
-       << std::setw(8) << h2
-       << std::setw(8) << h3
-       << std::setw(8) << h4
-       << std::setw(8) << h5
-       << std::setw(8) << h6
-       << std::setw(8) << h7;
+        level.swap(parents);
+    }
     
-    return ss.str();
+    return level.front();
 }
 
-std::string sha256File(const std::string& filePath) {
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file for hashing: " + filePath);
+// Parent of two tree nodes
+static Hash256 treeNode(const Hash256& left, const Hash256& right) {
+    Sha256 ctx;
+    ctx.update(&TREE_NODE_PREFIX, 1);
+    ctx.update(left);
+    ctx.update(right);
+    return ctx.final();
+}
+
+std::vector<Hash256> sha256TreeProof(const std::vector<Hash256>& leaves, size_t index) {
+    if (index >= leaves.size()) {
+        throw std::out_of_range("Tree leaf index out of range");
     }
     
-    // Initialize hash values (first 32 bits of the fractional parts of the square roots of the first 8 primes)
-    uint32_t h0 = 0x6a09e667;
-    uint32_t h1 = 0xbb67ae85;
-    uint32_t h2 = 0x3c6ef372;
-    uint32_t h3 = 0xa54ff53a;
-    uint32_t h4 = 0x510e527f;
-    uint32_t h5 = 0x9b05688c;
-    uint32_t h6 = 0x1f83d9ab;
-    uint32_t h7 = 0x5be0cd19;
+    std::vector<Hash256> proof;
+    std::vector<Hash256> level = leaves;
     
-    // Buffer to read chunks of file
-    std::array<uint8_t, 64> buffer{};
-    
-    // Track total bytes read for padding and length calculation
-    uint64_t total_bytes_read = 0;
-    bool processed_padding = false;
-    
-    // Process file in 64-byte chunks
-    while (true) {
-        // Read a chunk from the file
-        file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
-        size_t bytes_read = file.gcount();
-        total_bytes_read += bytes_read;
-        
-        // If we've reached the end of the file
-        if (bytes_read < buffer.size()) {
-            // End of file - need to add padding
-            size_t pad_start = bytes_read;
-            
-            // Append the bit '1' (0x80)
-            buffer[pad_start] = 0x80;
-            pad_start++;
-            
-            // If there's room for the length in this chunk
-            if (pad_start <= 56) {
-                // Fill with zeros until the last 8 bytes
-                for (size_t i = pad_start; i < 56; i++) {
-                    buffer[i] = 0;
-                }
-                
-                // Last 8 bytes are the length in bits
-                uint64_t bit_len = total_bytes_read * 8;
-                for (int i = 0; i < 8; i++) {
-                    buffer[56 + i] = (bit_len >> (56 - i * 8)) & 0xff;
-                }
-                
-                processed_padding = true;
-            } else {
-                // Fill the rest of this chunk with zeros
-                for (size_t i = pad_start; i < buffer.size(); i++) {
-                    buffer[i] = 0;
-                }
-                
-                // Process this chunk
-                std::array<uint32_t, 64> w{};
-                
-                for (int i = 0; i < 16; i++) {
-                    w[i] = ((uint32_t)buffer[i * 4] << 24) |
-                           ((uint32_t)buffer[i * 4 + 1] << 16) |
-                           ((uint32_t)buffer[i * 4 + 2] << 8) |
-                           ((uint32_t)buffer[i * 4 + 3]);
-                }
-                
-                // Extend the 16 words into 64 words
-                for (int i = 16; i < 64; i++) {
-                    w[i] = gamma1(w[i - 2]) + w[i - 7] + gamma0(w[i - 15]) + w[i - 16];
-                }
-                
-                // Initialize working variables
-                uint32_t a = h0;
-                uint32_t b = h1;
-                uint32_t c = h2;
-                uint32_t d = h3;
-                uint32_t e = h4;
-                uint32_t f = h5;
-                uint32_t g = h6;
-                uint32_t h = h7;
-                
-                // Main loop
-                for (int i = 0; i < 64; i++) {
-                    uint32_t t1 = h + sigma1(e) + ch(e, f, g) + K[i] + w[i];
-                    uint32_t t2 = sigma0(a) + maj(a, b, c);
-                    
-                    h = g;
-                    g = f;
-                    f = e;
-                    e = d + t1;
-                    d = c;
-                    c = b;
-                    b = a;
-                    a = t1 + t2;
-                }
-                
-                // Add the compressed chunk to the current hash value
-                h0 += a;
-                h1 += b;
-                h2 += c;
-                h3 += d;
-                h4 += e;
-                h5 += f;
-                h6 += g;
-                h7 += h;
-                
-                // Create another chunk with zeros and the length at the end
-                std::fill(buffer.begin(), buffer.end(), 0);
-                
-                // Last 8 bytes are the length in bits
-                uint64_t bit_len = total_bytes_read * 8;
-                for (int i = 0; i < 8; i++) {
-                    buffer[56 + i] = (bit_len >> (56 - i * 8)) & 0xff;
-                }
-                
-                processed_padding = true;
-            }
+    while (level.size() > 1) {
+        // A carried-up odd node has no sibling at this level
+        size_t sibling = index ^ 1;
+        if (sibling < level.size()) {
+            proof.push_back(level[sibling]);
         }
         
-        // If we've reached the end of file and processed padding, break
-        if (bytes_read < buffer.size() && processed_padding) {
-            break;
+        std::vector<Hash256> parents((level.size() + 1) / 2);
+        for (size_t i = 0; i + 1 < level.size(); i += 2) {
+            parents[i / 2] = treeNode(level[i], level[i + 1]);
         }
-        
-        // Process the chunk
-        std::array<uint32_t, 64> w{};
-        
-        for (int i = 0; i < 16; i++) {
-            w[i] = ((uint32_t)buffer[i * 4] << 24) |
-                   ((uint32_t)buffer[i * 4 + 1] << 16) |
-                   ((uint32_t)buffer[i * 4 + 2] << 8) |
-                   ((uint32_t)buffer[i * 4 + 3]);
+        if (level.size() % 2 == 1) {
+            parents.back() = level.back();
         }
         
-        // Extend the 16 words into 64 words
-        for (int i = 16; i < 64; i++) {
-            w[i] = gamma1(w[i - 2]) + w[i - 7] + gamma0(w[i - 15]) + w[i - 16];
+        level.swap(parents);
+        index /= 2;
+    }
+    
+    return proof;
+}
+
+Hash256 sha256TreeRootFromProof(const Hash256& leaf, size_t index, size_t leafCount,
+                                const std::vector<Hash256>& proof) {
+    if (index >= leafCount) {
+        return Hash256();
+    }
+    
+    Hash256 node = leaf;
+    size_t used = 0;
+    size_t levelSize = leafCount;
+    
+    while (levelSize > 1) {
+        size_t sibling = index ^ 1;
+        if (sibling < levelSize) {
+            if (used >= proof.size()) {
+                return Hash256();
+            }
+            node = (index % 2 == 0) ? treeNode(node, proof[used]) : treeNode(proof[used], node);
+            ++used;
         }
         
-        // Initialize working variables
-        uint32_t a = h0;
-        uint32_t b = h1;
-        uint32_t c = h2;
-        uint32_t d = h3;
-        uint32_t e = h4;
-        uint32_t f = h5;
-        uint32_t g = h6;
-        uint32_t h = h7;
+        levelSize = (levelSize + 1) / 2;
+        index /= 2;
+    }
+    
+    // Trailing proof entries mean the proof was built for a different tree
+    return used == proof.size() ? node : Hash256();
+}
+
+FileTreeHash sha256FileTree(const std::string& filePath) {
+    FileDescriptor file(filePath);
+    if (file.fd < 0) {
+        throw std::runtime_error("Failed to open file for hashing: " + filePath);
+    }
+    
+    struct stat st;
+    if (::fstat(file.fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        throw std::runtime_error("Chunked hashing requires a regular file: " + filePath);
+    }
+    
+    FileTreeHash result;
+    result.fileSize = static_cast<uint64_t>(st.st_size);
+    
+    // An empty file still has one (empty) chunk
+    size_t chunkCount = std::max<uint64_t>(1, (result.fileSize + TREE_HASH_CHUNK_SIZE - 1) / TREE_HASH_CHUNK_SIZE);
+    result.chunkHashes.resize(chunkCount);
+    
+    // Each worker streams through its own chunk, so sequential read-ahead still applies
+    FileMapping mapping(file.fd, static_cast<size_t>(result.fileSize), MADV_SEQUENTIAL);
+    
+    ThreadPool::shared().parallelFor(chunkCount, [&](size_t i) {
+        uint64_t offset = static_cast<uint64_t>(i) * TREE_HASH_CHUNK_SIZE;
+        size_t length = static_cast<size_t>(std::min<uint64_t>(TREE_HASH_CHUNK_SIZE, result.fileSize - offset));
         
-        // Main loop
-        for (int i = 0; i < 64; i++) {
-            uint32_t t1 = h + sigma1(e) + ch(e, f, g) + K[i] + w[i];
-            uint32_t t2 = sigma0(a) + maj(a, b, c);
-            
-            h = g;
-            g = f;
-            f = e;
-            e = d + t1;
-            d = c;
-            c = b;
-            b = a;
-            a = t1 + t2;
+        if (mapping.valid()) {
+            result.chunkHashes[i] = sha256TreeLeaf(mapping.bytes() + offset, length);
+            return;
         }
         
-        // Add the compressed chunk to the current hash value
-        h0 += a;
-        h1 += b;
-        h2 += c;
-        h3 += d;
-        h4 += e;
-        h5 += f;
-        h6 += g;
-        h7 += h;
-    }
-    
-    // Produce the final hash value as a 256-bit number in hex format
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0')
-       << std::setw(8) << h0
-       << std::setw(8) << h1
-       << std::setw(8) << h2
-       << std::setw(8) << h3
-       << std::setw(8) << h4
-       << std::setw(8) << h5
-       << std::setw(8) << h6
-       << std::setw(8) << h7;
+        std::vector<uint8_t> buffer(length);
+        if (!readFileRange(file.fd, buffer.data(), length, offset)) {
+            throw std::runtime_error("Failed to read file for hashing: " + filePath);
+        }
+        result.chunkHashes[i] = sha256TreeLeaf(buffer.data(), length);
+    });
     
-    return ss.str();
+    result.root = sha256TreeRoot(result.chunkHashes);
+    return result;
 }
 
 // Generate a simple random string
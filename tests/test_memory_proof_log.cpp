@@ -0,0 +1,121 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "../include/blockchain.h"
+#include "../include/memory_proof.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+MemoryProof makeProof(const fs::path& root, const std::string& uploader, int number,
+                      MemoryProof::ContentHashMode mode = MemoryProof::ContentHashMode::SHA256) {
+    std::string path = (root / (uploader + std::to_string(number) + ".txt")).string();
+    std::ofstream(path) << uploader << " memory " << number;
+    MemoryProof proof(path, MemoryProof::MemoryType::TEXT, uploader, "memory " + std::to_string(number), mode);
+    proof.signMemory(uploader);
+    return proof;
+}
+
+// A copy of the directory taken while the chain is running is what a
+// crash at that point would leave behind
+std::string crashImage(const std::string& directory, const fs::path& root) {
+    std::string image = (root / "crash").string();
+    fs::remove_all(image);
+    fs::copy(directory, image);
+    return image;
+}
+
+// Mining needs three memories on record, and a known memory cannot earn
+// a second reward, whichever hash mode it is proved with
+void checkProofsKnown(Blockchain& chain, const fs::path& root, const std::string& uploader,
+                      const std::string& stage) {
+    Block block;
+    check(chain.createBlockTemplate(uploader, block), stage + ": restored memories allow mining");
+    for (int i = 0; i < 3; ++i) {
+        check(!chain.storeMemoryProof(makeProof(root, uploader, i)), stage + ": memory cannot be stored twice");
+        check(!chain.storeMemoryProof(makeProof(root, uploader, i, MemoryProof::ContentHashMode::CHUNKED_TREE)),
+              stage + ": memory cannot be stored again as a tree");
+    }
+}
+
+} // namespace
+
+int main() {
+    fs::path root = fs::temp_directory_path() / ("ahmiyat_test_proofs_" + std::to_string(getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::string directory = (root / "chain").string();
+
+    // Proofs stored after the last state snapshot survive a crash
+    {
+        Blockchain chain;
+        check(chain.saveChain(directory), "create store");
+        for (int i = 0; i < 3; ++i) {
+            check(chain.storeMemoryProof(makeProof(root, "alice", i)), "store memory " + std::to_string(i));
+        }
+        checkProofsKnown(chain, root, "alice", "same run");
+
+        Blockchain restarted;
+        check(restarted.loadChain(crashImage(directory, root)), "restart after storing memories");
+        checkProofsKnown(restarted, root, "alice", "after crash");
+        check(restarted.storeMemoryProof(makeProof(root, "alice", 3)), "new memory stores after restart");
+    }
+
+    // Proofs stored before the store was attached are logged with it, so
+    // they do not depend on the snapshot either
+    {
+        std::string early = (root / "early").string();
+        Blockchain chain;
+        for (int i = 0; i < 3; ++i) {
+            check(chain.storeMemoryProof(makeProof(root, "bob", i)), "store memory before saving");
+        }
+        check(chain.saveChain(early), "save chain with memories");
+
+        std::string image = crashImage(early, root);
+        fs::remove(fs::path(image) / "state");
+        Blockchain restarted;
+        check(restarted.loadChain(image), "restart without a state snapshot");
+        checkProofsKnown(restarted, root, "bob", "without snapshot");
+    }
+
+    // A record cut short by a crash mid-write is dropped; one damaged in
+    // place fails the load
+    {
+        std::string log = (fs::path(directory) / "memory_proofs.dat").string();
+        auto size = fs::file_size(log);
+        std::ofstream(log, std::ios::app | std::ios::binary) << "AHMP\x40";
+
+        Blockchain torn;
+        check(torn.loadChain(crashImage(directory, root)), "restart with a torn proof record");
+        checkProofsKnown(torn, root, "alice", "torn tail");
+
+        fs::resize_file(log, size);
+        {
+            std::fstream file(log, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(static_cast<std::streamoff>(size / 2));
+            file.put('\x7f');
+        }
+        Blockchain damaged;
+        check(!damaged.loadChain(crashImage(directory, root)), "restart with a damaged proof record fails");
+    }
+
+    fs::remove_all(root);
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "memory proof log ok" << std::endl;
+    return 0;
+}
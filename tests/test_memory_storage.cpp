@@ -0,0 +1,107 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include "../include/memory_storage.h"
+#include "../include/utils.h"
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+std::string writeFile(const fs::path& root, const std::string& name, size_t length, char seed) {
+    std::string path = (root / name).string();
+    std::string content(length, '\0');
+    for (size_t i = 0; i < length; ++i) {
+        content[i] = static_cast<char>(seed + i * 31 + (i >> 12));
+    }
+    std::ofstream(path, std::ios::binary) << content;
+    return path;
+}
+
+bool storeRejected(MemoryStorage& storage, const std::string& path, MemoryProof::ContentHashMode mode) {
+    try {
+        storage.storeMemory(path, MemoryProof::MemoryType::TEXT, "alice", "duplicate", "alice", mode);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// Content stored under one hash mode is a duplicate under the other
+void checkDuplicates(MemoryStorage& storage, const fs::path& root, const std::string& treeFile,
+                     const std::string& plainFile, const std::string& stage) {
+    using Mode = MemoryProof::ContentHashMode;
+    check(storeRejected(storage, treeFile, Mode::SHA256), stage + ": tree upload again as SHA-256");
+    check(storeRejected(storage, treeFile, Mode::CHUNKED_TREE), stage + ": tree upload again as tree");
+    check(storeRejected(storage, plainFile, Mode::CHUNKED_TREE), stage + ": SHA-256 upload again as tree");
+
+    MemoryProof proof(plainFile, MemoryProof::MemoryType::TEXT, "bob", "copy", Mode::CHUNKED_TREE);
+    check(storage.memoryExists(proof), stage + ": content check finds the other mode");
+    check(!storage.storeMemory("bob", proof), stage + ": proof for stored content is rejected");
+
+    std::string fresh = writeFile(root, stage + "-fresh.bin", 1000, 'z');
+    MemoryProof freshProof(fresh, MemoryProof::MemoryType::TEXT, "bob", "new", Mode::SHA256);
+    check(!storage.memoryExists(freshProof), stage + ": new content is not a duplicate");
+}
+
+} // namespace
+
+int main() {
+    fs::path root = fs::temp_directory_path() / ("ahmiyat_test_storage_" + std::to_string(getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::string baseDir = (root / "memories").string();
+
+    // Spans three chunks, the last one partial
+    std::string treeFile = writeFile(root, "tree.bin", 2 * ahmiyat::utils::TREE_HASH_CHUNK_SIZE + 12345, 'a');
+    std::string plainFile = writeFile(root, "plain.bin", 5000, 'p');
+    Hash256 treeHash;
+
+    {
+        MemoryStorage storage(baseDir);
+        MemoryProof tree = storage.storeMemory(treeFile, MemoryProof::MemoryType::TEXT, "alice", "tree", "alice",
+                                               MemoryProof::ContentHashMode::CHUNKED_TREE);
+        storage.storeMemory(plainFile, MemoryProof::MemoryType::TEXT, "alice", "plain", "alice");
+        treeHash = tree.getFileHash();
+        check(tree.getChunkHashes().size() == 3, "tree proof has a hash per chunk");
+        checkDuplicates(storage, root, treeFile, plainFile, "same run");
+    }
+
+    // Chunk hashes and content keys come back with the index
+    {
+        MemoryStorage storage(baseDir);
+        check(storage.getMemoryCount("alice") == 2, "reloaded index has both memories");
+        for (size_t i = 0; i < 3; ++i) {
+            check(storage.verifyMemoryChunk(treeHash, i), "reloaded chunk " + std::to_string(i) + " verifies");
+        }
+        check(!storage.verifyMemoryChunk(treeHash, 3), "no chunk past the end");
+        checkDuplicates(storage, root, treeFile, plainFile, "reloaded");
+
+        // A stored chunk that changed on disk no longer verifies
+        {
+            std::fstream stored(storage.retrieveMemory(treeHash), std::ios::in | std::ios::out | std::ios::binary);
+            stored.seekp(static_cast<std::streamoff>(ahmiyat::utils::TREE_HASH_CHUNK_SIZE + 7));
+            stored.put('\x7f');
+        }
+        check(storage.verifyMemoryChunk(treeHash, 0) && !storage.verifyMemoryChunk(treeHash, 1),
+              "only the modified chunk fails");
+    }
+
+    fs::remove_all(root);
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "memory storage ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "../include/blockchain.h"
+#include "../include/block_store.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+const size_t CHAIN_LENGTH = 240;
+const size_t PRUNE_DEPTH = 50;
+const time_t START_TIME = 1700000000;
+
+// The next block, stamped one target interval after its parent so the
+// difficulty stays at its easiest and mining is instant
+Block makeBlock(const Blockchain& chain) {
+    auto headers = chain.getChainSnapshot();
+    size_t height = headers->size();
+    Block block(height, {Transaction("", "miner", 1.0)}, headers->back().getHash(), chain.getNextTargetBits());
+
+    std::string json = block.toJson();
+    std::string field = "\"timestamp\": ";
+    size_t start = json.find(field) + field.size();
+    json.replace(start, json.find(',', start) - start,
+                 std::to_string(START_TIME + height * Blockchain::TARGET_BLOCK_INTERVAL));
+
+    Block stamped = Block::fromJson(json);
+    stamped.updateMerkleRoot();
+    stamped.mineBlock("miner", 1);
+    return stamped;
+}
+
+// Small segments, so pruning has whole segments to drop well within the
+// chain. Blocks written by a Blockchain go to its default-sized segments
+bool writeSmallSegments(const std::vector<Block>& blocks, const std::string& directory) {
+    BlockStore store(directory, 4096);
+    std::vector<BlockHeader> headers;
+    if (!store.open(headers) || !headers.empty()) {
+        return false;
+    }
+    uint64_t sequence = 0;
+    for (const auto& block : blocks) {
+        if (!store.append(block, sequence)) {
+            return false;
+        }
+    }
+    return store.sync(sequence);
+}
+
+// Load a copy of the directory, as a restart after a crash at this point would
+void checkRestart(const std::string& directory, const std::string& crashImage, size_t chainSize,
+                  const std::string& stage) {
+    fs::remove_all(crashImage);
+    fs::copy(directory, crashImage);
+
+    Blockchain restarted;
+    restarted.setPruneDepth(PRUNE_DEPTH);
+    check(restarted.loadChain(crashImage), stage + ": restart loads");
+    check(restarted.getChainSize() == chainSize, stage + ": restart keeps every header");
+    check(restarted.getPrunedHeight() > 0, stage + ": restart stays pruned");
+    // Each block pays the miner 1.0; a fresh chain has nothing pending
+    check(restarted.getBalance("miner") == static_cast<double>(chainSize - 1), stage + ": restart restores balances");
+    check(restarted.validateChain(ValidationMode::FULL_AUDIT).valid, stage + ": restarted chain validates");
+
+    // Paging the miner's history with a zero limit still advances, and
+    // ends cleanly at the pruned height
+    TransactionPage page = restarted.getTransactionsForAddress("miner", 0, 0);
+    size_t pages = 1;
+    while (page.hasMore && pages <= chainSize) {
+        check(page.transactions.size() == 1 && !page.incomplete, stage + ": zero limit reads one transaction");
+        page = restarted.getTransactionsForAddress("miner", page.nextCursor, 0);
+        ++pages;
+    }
+    check(!page.hasMore && !page.incomplete && pages > 1, stage + ": paging stops at the pruned height");
+    check(restarted.submitBlock(makeBlock(restarted)), stage + ": restarted chain accepts blocks");
+}
+
+} // namespace
+
+int main() {
+    fs::path root = fs::temp_directory_path() / ("ahmiyat_test_pruned_" + std::to_string(getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::string directory = (root / "chain").string();
+    std::string crashImage = (root / "crash").string();
+
+    std::vector<Block> blocks;
+    {
+        Blockchain chain;
+        while (chain.getChainSize() < CHAIN_LENGTH) {
+            check(chain.submitBlock(makeBlock(chain)), "mine block " + std::to_string(chain.getChainSize()));
+        }
+        blocks = chain.getChain();
+    }
+    check(writeSmallSegments(blocks, directory), "write segmented store");
+
+    {
+        Blockchain chain;
+        chain.setPruneDepth(PRUNE_DEPTH);
+        check(chain.loadChain(directory), "load segmented store");
+
+        // saveChain on the attached store flushes it, writes the state
+        // snapshot and prunes below it
+        check(chain.saveChain(directory), "save and prune");
+        size_t pruned = chain.getPrunedHeight();
+        check(pruned > 0 && pruned <= CHAIN_LENGTH - PRUNE_DEPTH, "pruned below the depth");
+        check(!chain.getBlock(0) && chain.getBlock(pruned) && chain.getBlock(CHAIN_LENGTH - 1),
+              "bodies below the pruned height are gone");
+        checkRestart(directory, crashImage, chain.getChainSize(), "after prune");
+
+        // Crossing a snapshot interval writes a snapshot (and prunes) in the
+        // background; saveChain waits for it, then a crash image taken before
+        // shutdown must restart from what is on disk
+        while (chain.getChainSize() % Blockchain::STATE_SNAPSHOT_INTERVAL != 1) {
+            check(chain.submitBlock(makeBlock(chain)), "mine past the snapshot interval");
+        }
+        check(chain.saveChain(directory), "save after background snapshot");
+        checkRestart(directory, crashImage, chain.getChainSize(), "after background snapshot");
+    }
+
+    // A clean shutdown leaves a loadable pruned store as well
+    {
+        Blockchain chain;
+        chain.setPruneDepth(PRUNE_DEPTH);
+        check(chain.loadChain(directory), "reload after shutdown");
+        check(chain.getPrunedHeight() > 0 && chain.validateChain(ValidationMode::FULL_AUDIT).valid,
+              "reloaded chain is pruned and valid");
+    }
+
+    // Without the state snapshot the pruned blocks' effect is lost, so the
+    // load fails; the chain it was loaded into must be left as it was
+    {
+        fs::remove_all(crashImage);
+        fs::copy(directory, crashImage);
+        fs::remove(fs::path(crashImage) / "state");
+
+        Blockchain chain;
+        chain.setPruneDepth(PRUNE_DEPTH);
+        Hash256 genesis = chain.getLatestBlock().getHash();
+        check(!chain.loadChain(crashImage), "load without the state snapshot fails");
+        check(chain.getChainSize() == 1 && chain.getLatestBlock().getHash() == genesis && chain.getBlock(0),
+              "failed load keeps the genesis block");
+        check(chain.getPrunedHeight() == 0 && chain.getValidationCheckpoint().height == 1,
+              "failed load leaves no store behind");
+        check(chain.submitBlock(makeBlock(chain)) && chain.getBalance("miner") > 0.0,
+              "chain accepts blocks after a failed load");
+        check(chain.saveChain((root / "fresh").string()), "chain saves after a failed load");
+    }
+
+    fs::remove_all(root);
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "pruned restarts ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/sha256.h"
+
+using ahmiyat::utils::Sha256;
+using ahmiyat::utils::Sha256Backend;
+using ahmiyat::utils::Sha256Midstate;
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+// Every length from empty through several blocks, so each padding case is
+// covered: the length field fits in the last block (<= 55 bytes over a
+// block boundary) or spills into an extra one (56..63)
+const size_t MAX_LENGTH = 300;
+
+std::vector<std::string> makeMessages() {
+    std::vector<std::string> messages;
+    for (size_t length = 0; length <= MAX_LENGTH; ++length) {
+        std::string message(length, '\0');
+        for (size_t i = 0; i < length; ++i) {
+            message[i] = static_cast<char>((i * 131 + length * 7) & 0xff);
+        }
+        messages.push_back(message);
+    }
+    return messages;
+}
+
+Hash256 hashWith(const std::string& message) {
+    Sha256 ctx;
+    ctx.update(message);
+    return ctx.final();
+}
+
+// Feed the message in uneven pieces to exercise the partial-block buffer
+Hash256 hashInPieces(const std::string& message) {
+    Sha256 ctx;
+    size_t offset = 0;
+    for (size_t piece = 1; offset < message.size(); piece = piece * 3 % 71 + 1) {
+        size_t length = std::min(piece, message.size() - offset);
+        ctx.update(message.data() + offset, length);
+        offset += length;
+    }
+    return ctx.final();
+}
+
+void testKnownVectors() {
+    ahmiyat::utils::sha256SetBackend(Sha256Backend::SCALAR);
+    check(hashWith("").toHex() == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", "empty message");
+    check(hashWith("abc").toHex() == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", "abc");
+    check(hashWith("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq").toHex() ==
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", "two-block message");
+}
+
+void testBackends(const std::vector<std::string>& messages, const std::vector<Hash256>& expected) {
+    for (Sha256Backend backend : {Sha256Backend::SCALAR, Sha256Backend::SHA_NI}) {
+        const char* name = ahmiyat::utils::sha256BackendName(backend);
+        if (!ahmiyat::utils::sha256SetBackend(backend)) {
+            std::cout << "skipping unsupported backend " << name << std::endl;
+            continue;
+        }
+        for (size_t i = 0; i < messages.size(); ++i) {
+            check(hashWith(messages[i]) == expected[i], std::string(name) + " length " + std::to_string(i));
+            check(hashInPieces(messages[i]) == expected[i], std::string(name) + " pieces length " + std::to_string(i));
+        }
+    }
+    ahmiyat::utils::sha256SetBackend(Sha256Backend::SCALAR);
+}
+
+void testBatch(const std::vector<std::string>& messages, const std::vector<Hash256>& expected,
+               const std::string& name) {
+    // Adjacent lengths share a batch, so lanes finish on different blocks
+    std::vector<Hash256> digests = ahmiyat::utils::sha256Batch(messages);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        check(digests[i] == expected[i], name + " length " + std::to_string(i));
+    }
+
+    // Interleave short and long messages and cover partial final batches
+    for (size_t count = 1; count <= 17; ++count) {
+        std::vector<std::string> mixed;
+        std::vector<Hash256> mixedExpected;
+        for (size_t i = 0; i < count; ++i) {
+            size_t length = (i * 97 + count * 13) % (MAX_LENGTH + 1);
+            mixed.push_back(messages[length]);
+            mixedExpected.push_back(expected[length]);
+        }
+        check(ahmiyat::utils::sha256Batch(mixed) == mixedExpected, name + " mixed batch of " + std::to_string(count));
+    }
+}
+
+void testMidstate(const std::vector<std::string>& messages, const std::string& name) {
+    const std::string prefix = messages[128];
+    Sha256Midstate midstate(prefix.data(), prefix.size());
+
+    std::vector<const uint8_t*> tails;
+    std::vector<size_t> lengths;
+    std::vector<Hash256> expected;
+    for (const auto& message : messages) {
+        tails.push_back(reinterpret_cast<const uint8_t*>(message.data()));
+        lengths.push_back(message.size());
+        expected.push_back(hashWith(prefix + message));
+    }
+
+    std::vector<Hash256> digests(messages.size());
+    midstate.finishBatch(tails.data(), lengths.data(), digests.data(), digests.size());
+    for (size_t i = 0; i < messages.size(); ++i) {
+        check(midstate.finish(messages[i].data(), messages[i].size()) == expected[i], name + " midstate length " + std::to_string(i));
+        check(digests[i] == expected[i], name + " midstate batch length " + std::to_string(i));
+    }
+}
+
+} // namespace
+
+int main() {
+    testKnownVectors();
+
+    // The scalar kernel is the reference every other path must match
+    std::vector<std::string> messages = makeMessages();
+    std::vector<Hash256> expected;
+    for (const auto& message : messages) {
+        expected.push_back(hashWith(message));
+    }
+
+    testBackends(messages, expected);
+
+    // Every multi-buffer width the CPU can run: AVX-512, AVX2 and sequential
+    for (size_t lanes : {16, 8, 1}) {
+        std::string name = std::to_string(lanes) + "-lane batch";
+        if (!ahmiyat::utils::sha256SetBatchLanes(lanes)) {
+            std::cout << "skipping unsupported " << name << std::endl;
+            continue;
+        }
+        testBatch(messages, expected, name);
+        testMidstate(messages, name);
+    }
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "sha256 backends agree" << std::endl;
+    return 0;
+}
@@ -6,6 +6,7 @@
 #include <mutex>
 
 #include "simple_http_server.h"
+#include "mining_service.h"
 #include "../../include/blockchain.h"
 #include "../../include/wallet.h"
 #include "../../include/memory_proof.h"
@@ -17,7 +18,7 @@ namespace web {
 
 class AhmiyatWebApp {
 public:
-    AhmiyatWebApp(int port = 5000);
+    AhmiyatWebApp(int port = 5000, size_t pruneDepth = Blockchain::NO_PRUNING);
     
     void start();
     void stop();
@@ -35,6 +36,9 @@ private:
     // Memory storage instance
     std::shared_ptr<MemoryStorage> m_storage;
     
+    // Background miner for /api/mine jobs
+    std::unique_ptr<MiningService> m_miningService;
+    
     // User wallets (address -> wallet)
     std::unordered_map<std::string, Wallet> m_wallets;
     std::mutex m_walletsMutex;
@@ -56,8 +60,12 @@ private:
     HttpResponse handleGetMemories(const HttpRequest& req);
     HttpResponse handleGetTransactions(const HttpRequest& req);
     HttpResponse handleMine(const HttpRequest& req);
+    HttpResponse handleMineStatus(const HttpRequest& req);
+    HttpResponse handleMineCancel(const HttpRequest& req);
+    HttpResponse handleMiningStats(const HttpRequest& req);
     HttpResponse handleTransfer(const HttpRequest& req);
     HttpResponse handleGetBlockchain(const HttpRequest& req);
+    HttpResponse handleBlockCacheStats(const HttpRequest& req);
     HttpResponse handleStaticFiles(const HttpRequest& req);
     HttpResponse handleStaticFilesNoPrefixCSS(const HttpRequest& req);
     HttpResponse handleStaticFilesNoPrefixJS(const HttpRequest& req);
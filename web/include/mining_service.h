@@ -0,0 +1,145 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <unordered_map>
+
+#include "../../include/blockchain.h"
+
+namespace ahmiyat {
+namespace web {
+
+enum class MiningJobState {
+    QUEUED,
+    RUNNING,
+    SUCCEEDED,
+    FAILED,
+    CANCELLED
+};
+
+std::string miningJobStateToString(MiningJobState state);
+
+/**
+ * @struct MiningJob
+ * @brief Snapshot of one background mining request
+ */
+struct MiningJob {
+    std::string id;
+    std::string minerAddress;
+    MiningJobState state = MiningJobState::QUEUED;
+    uint64_t hashesTried = 0;   // Across every template mined for this job
+    uint32_t templates = 0;     // Templates mined; more than one after a stale block
+    uint32_t blockIndex = 0;    // Valid when the job succeeded
+    std::string blockHash;      // Valid when the job succeeded
+    std::string message;        // Reason for a failure or cancellation
+    std::chrono::steady_clock::time_point submitted;
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point finished;
+
+    bool isActive() const {
+        return state == MiningJobState::QUEUED || state == MiningJobState::RUNNING;
+    }
+};
+
+/**
+ * @class MiningService
+ * @brief Mines blocks on a background thread on behalf of web requests
+ *
+ * Jobs are queued and mined one at a time. Each job takes a block template
+ * from the blockchain, searches for a nonce without holding any chain or
+ * server lock, and submits the result; if another block was added in the
+ * meantime the template is stale and a fresh one is mined.
+ */
+class MiningService {
+public:
+    /**
+     * @brief Stale templates re-mined before a job gives up
+     */
+    static constexpr uint32_t MAX_STALE_RETRIES = 3;
+
+    /**
+     * @brief Finished jobs kept for status queries
+     */
+    static constexpr size_t MAX_FINISHED_JOBS = 256;
+
+    /**
+     * @brief Create a mining service
+     * @param blockchain Chain to mine on
+     * @param threadCount Mining threads per job, 0 for one per hardware thread
+     */
+    explicit MiningService(std::shared_ptr<Blockchain> blockchain, size_t threadCount = 0);
+    ~MiningService();
+
+    void start();
+
+    /**
+     * @brief Cancel every queued and running job and stop the worker
+     */
+    void stop();
+
+    /**
+     * @brief Queue a mining job
+     * @param minerAddress Address that receives the block reward
+     * @return Job id; the id of the address's existing job if one is still active
+     */
+    std::string submit(const std::string& minerAddress);
+
+    /**
+     * @brief Look up a job, including the live hash count of a running one
+     * @param id Job id
+     * @param job Receives the job snapshot
+     * @return False if the id is unknown
+     */
+    bool getJob(const std::string& id, MiningJob& job) const;
+
+    /**
+     * @brief Most recent job submitted for an address
+     * @param minerAddress Miner address
+     * @param job Receives the job snapshot
+     * @return False if the address has no jobs
+     */
+    bool getLatestJob(const std::string& minerAddress, MiningJob& job) const;
+
+    /**
+     * @brief Cancel a queued or running job
+     * @param id Job id
+     * @return False if the job is unknown or already finished
+     */
+    bool cancel(const std::string& id);
+
+private:
+    std::shared_ptr<Blockchain> m_blockchain;
+    size_t m_threadCount;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_worker;
+    bool m_running;
+    uint64_t m_nextJobId;
+
+    std::unordered_map<std::string, MiningJob> m_jobs;
+    std::unordered_map<std::string, std::string> m_latestJobs; // address -> job id
+    std::deque<std::string> m_queue;
+    std::deque<std::string> m_finished;                        // Oldest first
+
+    // The job being mined; its hash count is published through
+    // m_currentHashes so status queries need not stop the miner
+    std::string m_currentJob;
+    std::atomic<uint64_t> m_currentHashes;
+    std::atomic<bool> m_cancelCurrent;
+
+    void workerLoop();
+    void runJob(const std::string& id, const std::string& minerAddress);
+    void finishJob(MiningJob& job, MiningJobState state, const std::string& message);
+    MiningJob snapshot(const MiningJob& job) const;
+};
+
+} // namespace web
+} // namespace ahmiyat
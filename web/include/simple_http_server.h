@@ -25,7 +25,8 @@ enum class HttpMethod {
 
 struct HttpRequest {
     HttpMethod method;
-    std::string uri;
+    std::string uri;                                     // Path, without the query string
+    std::unordered_map<std::string, std::string> query;  // Decoded query parameters
     std::unordered_map<std::string, std::string> headers;
     std::string body;
     
@@ -36,6 +37,14 @@ struct HttpRequest {
         }
         return "";
     }
+    
+    std::string getQueryParam(const std::string& name) const {
+        auto it = query.find(name);
+        if (it != query.end()) {
+            return it->second;
+        }
+        return "";
+    }
 };
 
 struct HttpResponse {
@@ -99,6 +108,7 @@ private:
     std::string statusCodeToString(int status_code);
     
     static void urlDecode(std::string& text);
+    static void parseQuery(const std::string& queryString, std::unordered_map<std::string, std::string>& query);
 };
 
 } // namespace web
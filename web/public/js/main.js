@@ -193,8 +193,12 @@ document.addEventListener('DOMContentLoaded', function() {
     }
     
     // Load user transactions
-    function loadUserTransactions() {
-        fetch('/api/transactions', {
+    // Transactions arrive newest first, one page at a time; a cursor
+    // continues with older ones
+    function loadUserTransactions(cursor) {
+        const url = cursor ? '/api/transactions?cursor=' + encodeURIComponent(cursor) : '/api/transactions';
+        
+        fetch(url, {
             headers: {
                 'Authorization': currentUser.token
             }
@@ -203,7 +207,14 @@ document.addEventListener('DOMContentLoaded', function() {
         .then(data => {
             if (data.transactions && data.transactions.length > 0) {
                 noTransactionsMessage.style.display = 'none';
-                transactionList.innerHTML = '';
+                if (!cursor) {
+                    transactionList.innerHTML = '';
+                }
+                
+                const previousMoreButton = document.getElementById('load-more-transactions');
+                if (previousMoreButton) {
+                    previousMoreButton.remove();
+                }
                 
                 data.transactions.forEach(tx => {
                     const txElement = document.createElement('div');
@@ -232,7 +243,16 @@ document.addEventListener('DOMContentLoaded', function() {
                     
                     transactionList.appendChild(txElement);
                 });
-            } else {
+                
+                if (data.hasMore) {
+                    const moreButton = document.createElement('button');
+                    moreButton.id = 'load-more-transactions';
+                    moreButton.className = 'btn';
+                    moreButton.textContent = 'Load older transactions';
+                    moreButton.addEventListener('click', () => loadUserTransactions(data.nextCursor));
+                    transactionList.appendChild(moreButton);
+                }
+            } else if (!cursor) {
                 noTransactionsMessage.style.display = 'block';
             }
         })
@@ -619,8 +639,52 @@ document.addEventListener('DOMContentLoaded', function() {
             return;
         }
         
-        this.disabled = true;
-        this.textContent = 'Mining...';
+        const button = this;
+        button.disabled = true;
+        button.textContent = 'Mining...';
+        
+        const finish = () => {
+            button.disabled = false;
+            button.textContent = 'Mine Blocks';
+        };
+        
+        // Mining runs as a background job on the server; poll until it finishes
+        const pollStatus = (jobId) => {
+            fetch('/api/mine/status?id=' + encodeURIComponent(jobId), {
+                headers: {
+                    'Authorization': currentUser.token
+                }
+            })
+            .then(response => {
+                if (!response.ok) {
+                    throw new Error('Mining status unavailable');
+                }
+                return response.json();
+            })
+            .then(data => {
+                if (data.state === 'queued' || data.state === 'running') {
+                    button.textContent = 'Mining... ' + Math.round(data.hashRate / 1000) + ' kH/s';
+                    setTimeout(() => pollStatus(jobId), 1000);
+                    return;
+                }
+                
+                if (data.state === 'succeeded') {
+                    alert('Mining successful! New balance: ' + data.balance.toFixed(2) + ' AHM');
+                    walletBalance.textContent = data.balance.toFixed(2);
+                    
+                    // Reload transactions
+                    loadUserTransactions();
+                } else {
+                    alert('Mining ' + data.state + ': ' + (data.message || 'Please try again.'));
+                }
+                finish();
+            })
+            .catch(error => {
+                console.error('Mining error:', error);
+                alert('Mining failed. Please try again.');
+                finish();
+            });
+        };
         
         fetch('/api/mine', {
             method: 'POST',
@@ -635,19 +699,12 @@ document.addEventListener('DOMContentLoaded', function() {
             return response.json();
         })
         .then(data => {
-            alert('Mining successful! New balance: ' + data.balance.toFixed(2) + ' AHM');
-            walletBalance.textContent = data.balance.toFixed(2);
-            
-            // Reload transactions
-            loadUserTransactions();
+            pollStatus(data.jobId);
         })
         .catch(error => {
             console.error('Mining error:', error);
             alert('Mining failed. Please try again.');
-        })
-        .finally(() => {
-            this.disabled = false;
-            this.textContent = 'Mine Blocks';
+            finish();
         });
     });
     
@@ -1,10 +1,12 @@
 #include "../include/ahmiyat_web.h"
+#include "../../include/target.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <random>
 #include <chrono>
 #include <filesystem>
+#include <algorithm>
 #include <nlohmann/json.hpp>
 
 namespace ahmiyat {
@@ -12,13 +14,56 @@ namespace web {
 
 using json = nlohmann::json;
 
-AhmiyatWebApp::AhmiyatWebApp(int port) : m_port(port) {
+namespace {
+
+// Page size bounds for /api/transactions
+constexpr size_t DEFAULT_TRANSACTION_PAGE_SIZE = 50;
+constexpr size_t MAX_TRANSACTION_PAGE_SIZE = 500;
+
+// Block store directory, relative to the working directory
+constexpr const char* CHAIN_DIRECTORY = "blockchain_data";
+
+json miningJobToJson(const MiningJob& job) {
+    // Mining time only; jobs cancelled while queued never started
+    double elapsed = 0.0;
+    if (job.started != std::chrono::steady_clock::time_point()) {
+        auto end = job.isActive() ? std::chrono::steady_clock::now() : job.finished;
+        elapsed = std::chrono::duration<double>(end - job.started).count();
+    }
+
+    json result;
+    result["jobId"] = job.id;
+    result["state"] = miningJobStateToString(job.state);
+    result["hashesTried"] = job.hashesTried;
+    result["elapsedSeconds"] = elapsed;
+    result["hashRate"] = elapsed > 0.0 ? job.hashesTried / elapsed : 0.0;
+    result["templates"] = job.templates;
+    if (job.state == MiningJobState::SUCCEEDED) {
+        result["blockIndex"] = job.blockIndex;
+        result["blockHash"] = job.blockHash;
+    }
+    if (!job.message.empty()) {
+        result["message"] = job.message;
+    }
+    return result;
+}
+
+} // namespace
+
+AhmiyatWebApp::AhmiyatWebApp(int port, size_t pruneDepth) : m_port(port) {
     // Initialize blockchain
     m_blockchain = std::make_shared<Blockchain>();
+    m_blockchain->setPruneDepth(pruneDepth);
+    if (!m_blockchain->loadChain(CHAIN_DIRECTORY)) {
+        std::cerr << "Failed to open the block store; the chain will not be saved" << std::endl;
+    }
 
     // Initialize memory storage
     m_storage = std::make_shared<MemoryStorage>();
 
+    // Initialize the background miner
+    m_miningService = std::make_unique<MiningService>(m_blockchain);
+
     // Initialize HTTP server
     m_server = std::make_unique<SimpleHttpServer>(port);
 
@@ -31,12 +76,14 @@ AhmiyatWebApp::AhmiyatWebApp(int port) : m_port(port) {
 
 void AhmiyatWebApp::start() {
     std::cout << "Starting Ahmiyat web server on port " << m_port << std::endl;
+    m_miningService->start();
     m_server->start();
 }
 
 void AhmiyatWebApp::stop() {
     std::cout << "Stopping Ahmiyat web server" << std::endl;
     m_server->stop();
+    m_miningService->stop();
 
     // Save wallets before exit
     saveWallets();
@@ -58,8 +105,12 @@ void AhmiyatWebApp::setupRoutes() {
     m_server->addRoute(HttpMethod::GET, "/api/memories", std::bind(&AhmiyatWebApp::handleGetMemories, this, std::placeholders::_1));
     m_server->addRoute(HttpMethod::GET, "/api/transactions", std::bind(&AhmiyatWebApp::handleGetTransactions, this, std::placeholders::_1));
     m_server->addRoute(HttpMethod::POST, "/api/mine", std::bind(&AhmiyatWebApp::handleMine, this, std::placeholders::_1));
+    m_server->addRoute(HttpMethod::GET, "/api/mine/status", std::bind(&AhmiyatWebApp::handleMineStatus, this, std::placeholders::_1));
+    m_server->addRoute(HttpMethod::POST, "/api/mine/cancel", std::bind(&AhmiyatWebApp::handleMineCancel, this, std::placeholders::_1));
+    m_server->addRoute(HttpMethod::GET, "/api/mining/stats", std::bind(&AhmiyatWebApp::handleMiningStats, this, std::placeholders::_1));
     m_server->addRoute(HttpMethod::POST, "/api/transfer", std::bind(&AhmiyatWebApp::handleTransfer, this, std::placeholders::_1));
     m_server->addRoute(HttpMethod::GET, "/api/blockchain", std::bind(&AhmiyatWebApp::handleGetBlockchain, this, std::placeholders::_1));
+    m_server->addRoute(HttpMethod::GET, "/api/blockchain/cache", std::bind(&AhmiyatWebApp::handleBlockCacheStats, this, std::placeholders::_1));
 
     // Static files handlers - with and without /public prefix
     m_server->addRoute(HttpMethod::GET, "/public/css/styles.css", std::bind(&AhmiyatWebApp::handleStaticFiles, this, std::placeholders::_1));
@@ -244,6 +295,13 @@ HttpResponse AhmiyatWebApp::handleUploadMemory(const HttpRequest& req) {
             type = MemoryProof::MemoryType::TEXT;
         }
 
+        // Optional content hash mode; chunked tree hashing spreads large files across cores
+        MemoryProof::ContentHashMode hashMode = MemoryProof::ContentHashMode::SHA256;
+        if (body.contains("hashMode") && body["hashMode"].is_string() &&
+            body["hashMode"].get<std::string>() == "tree") {
+            hashMode = MemoryProof::ContentHashMode::CHUNKED_TREE;
+        }
+
         // Check if the request has file data
         std::string fileData;
         std::string fileName;
@@ -369,7 +427,7 @@ HttpResponse AhmiyatWebApp::handleUploadMemory(const HttpRequest& req) {
         file.close();
 
         // Create a memory proof
-        MemoryProof proof(filename, type, address, description);
+        MemoryProof proof(filename, type, address, description, hashMode);
 
         // Get the wallet for signing
         std::string privateKey;
@@ -384,6 +442,12 @@ HttpResponse AhmiyatWebApp::handleUploadMemory(const HttpRequest& req) {
         // Sign the memory proof
         proof.signMemory(privateKey);
 
+        // Cheap early reject; the blockchain makes the final duplicate check
+        // under its own lock, by the proof's content key
+        if (m_storage->memoryExists(proof)) {
+            return HttpResponse(400, "application/json", "{\"error\":\"Memory already exists\"}");
+        }
+
         // Store the memory proof and add a reward transaction
         bool success = m_blockchain->storeMemoryProof(proof);
         if (!success) {
@@ -398,7 +462,8 @@ HttpResponse AhmiyatWebApp::handleUploadMemory(const HttpRequest& req) {
         // Return the proof details
         json result;
         result["success"] = true;
-        result["proofHash"] = proof.getProofHash();
+        result["proofHash"] = proof.getProofHash().toHex();
+        result["hashMode"] = MemoryProof::contentHashModeToString(proof.getContentHashMode());
         result["timestamp"] = utils::timeToString(proof.getTimestamp());
 
         return HttpResponse(200, "application/json", result.dump());
@@ -422,8 +487,8 @@ HttpResponse AhmiyatWebApp::handleGetMemories(const HttpRequest& req) {
 
     for (const auto& proof : memories) {
         json memory;
-        memory["proofHash"] = proof.getProofHash();
-        memory["fileHash"] = proof.getFileHash();
+        memory["proofHash"] = proof.getProofHash().toHex();
+        memory["fileHash"] = proof.getFileHash().toHex();
         memory["type"] = MemoryProof::memoryTypeToString(proof.getType());
         memory["description"] = proof.getDescription();
         memory["timestamp"] = utils::timeToString(proof.getTimestamp());
@@ -443,29 +508,50 @@ HttpResponse AhmiyatWebApp::handleGetTransactions(const HttpRequest& req) {
         return HttpResponse(401, "application/json", "{\"error\":\"Unauthorized\"}");
     }
 
-    // Get all blocks in the chain
-    auto chain = m_blockchain->getChain();
+    // Optional paging: ?cursor=<nextCursor from the previous page>&limit=<n>
+    size_t cursor = 0;
+    size_t limit = DEFAULT_TRANSACTION_PAGE_SIZE;
+    try {
+        if (!req.getQueryParam("cursor").empty()) {
+            cursor = std::stoul(req.getQueryParam("cursor"));
+        }
+        if (!req.getQueryParam("limit").empty()) {
+            limit = std::stoul(req.getQueryParam("limit"));
+        }
+    } catch (const std::exception& e) {
+        return HttpResponse(400, "application/json", "{\"error\":\"Invalid cursor or limit\"}");
+    }
+    limit = std::max<size_t>(1, std::min(limit, MAX_TRANSACTION_PAGE_SIZE));
+
+    // Only this address's transactions are read, newest first
+    TransactionPage page = m_blockchain->getTransactionsForAddress(address, cursor, limit);
 
-    // Extract transactions for the user
     json result;
     json txList = json::array();
 
-    for (const auto& block : chain) {
-        for (const auto& tx : block.getTransactions()) {
-            if (tx.getFromAddress() == address || tx.getToAddress() == address) {
-                json txJson;
-                txJson["fromAddress"] = tx.getFromAddress();
-                txJson["toAddress"] = tx.getToAddress();
-                txJson["amount"] = tx.getAmount();
-                txJson["timestamp"] = utils::timeToString(tx.getTimestamp());
-                txJson["type"] = static_cast<int>(tx.getType());
-
-                txList.push_back(txJson);
-            }
-        }
+    for (size_t i = 0; i < page.transactions.size(); ++i) {
+        const Transaction& tx = page.transactions[i];
+
+        json txJson;
+        txJson["fromAddress"] = tx.getFromAddress();
+        txJson["toAddress"] = tx.getToAddress();
+        txJson["amount"] = tx.getAmount();
+        txJson["timestamp"] = utils::timeToString(tx.getTimestamp());
+        txJson["type"] = static_cast<int>(tx.getType());
+        txJson["blockIndex"] = page.locations[i].blockIndex;
+
+        txList.push_back(txJson);
     }
 
     result["transactions"] = txList;
+    result["total"] = page.total;
+    result["hasMore"] = page.hasMore;
+    result["incomplete"] = page.incomplete;
+    if (page.hasMore) {
+        result["nextCursor"] = page.nextCursor;
+    } else {
+        result["nextCursor"] = nullptr;
+    }
 
     return HttpResponse(200, "application/json", result.dump());
 }
@@ -476,17 +562,116 @@ HttpResponse AhmiyatWebApp::handleMine(const HttpRequest& req) {
         return HttpResponse(401, "application/json", "{\"error\":\"Unauthorized\"}");
     }
 
-    // Mine pending transactions
-    m_blockchain->minePendingTransactions(address);
+    // Queue the job and return at once; the block is mined in the background
+    std::string jobId = m_miningService->submit(address);
 
-    // Get the new balance
-    double balance = m_blockchain->getBalance(address);
+    MiningJob job;
+    if (!m_miningService->getJob(jobId, job)) {
+        return HttpResponse(500, "application/json", "{\"error\":\"Mining job not found\"}");
+    }
+
+    json result = miningJobToJson(job);
+    result["success"] = true;
+    result["jobId"] = jobId;
+
+    return HttpResponse(202, "application/json", result.dump());
+}
+
+HttpResponse AhmiyatWebApp::handleMineStatus(const HttpRequest& req) {
+    std::string address = getAuthenticatedAddress(req);
+    if (address.empty()) {
+        return HttpResponse(401, "application/json", "{\"error\":\"Unauthorized\"}");
+    }
+
+    // Without an id, report the caller's most recent job
+    MiningJob job;
+    std::string jobId = req.getQueryParam("id");
+    bool found = jobId.empty() ? m_miningService->getLatestJob(address, job)
+                               : m_miningService->getJob(jobId, job);
+    if (!found || job.minerAddress != address) {
+        return HttpResponse(404, "application/json", "{\"error\":\"Mining job not found\"}");
+    }
+
+    json result = miningJobToJson(job);
+    result["success"] = true;
+    if (job.state == MiningJobState::SUCCEEDED) {
+        result["balance"] = m_blockchain->getBalance(address);
+    }
+
+    return HttpResponse(200, "application/json", result.dump());
+}
+
+HttpResponse AhmiyatWebApp::handleMineCancel(const HttpRequest& req) {
+    std::string address = getAuthenticatedAddress(req);
+    if (address.empty()) {
+        return HttpResponse(401, "application/json", "{\"error\":\"Unauthorized\"}");
+    }
+
+    std::string jobId;
+    try {
+        json body = json::parse(req.body);
+        if (body.contains("jobId")) {
+            jobId = body["jobId"];
+        }
+    } catch (const std::exception& e) {
+        return HttpResponse(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+    }
+
+    MiningJob job;
+    if (jobId.empty() || !m_miningService->getJob(jobId, job) || job.minerAddress != address) {
+        return HttpResponse(404, "application/json", "{\"error\":\"Mining job not found\"}");
+    }
+
+    if (!m_miningService->cancel(jobId)) {
+        return HttpResponse(409, "application/json", "{\"error\":\"Mining job already finished\"}");
+    }
 
-    // Return the result
     json result;
     result["success"] = true;
-    result["message"] = "Mining successful";
-    result["balance"] = balance;
+    result["jobId"] = jobId;
+
+    return HttpResponse(200, "application/json", result.dump());
+}
+
+HttpResponse AhmiyatWebApp::handleMiningStats(const HttpRequest& req) {
+    MiningStats stats = m_blockchain->getMiningStats();
+
+    json histogram = json::array();
+    for (size_t i = 0; i < stats.solveTimeHistogram.size(); ++i) {
+        json bucket;
+        if (i < MiningStats::SOLVE_TIME_BOUNDS.size()) {
+            bucket["maxSeconds"] = MiningStats::SOLVE_TIME_BOUNDS[i];
+        } else {
+            bucket["maxSeconds"] = nullptr;
+        }
+        bucket["count"] = stats.solveTimeHistogram[i];
+        histogram.push_back(bucket);
+    }
+
+    // What the next block should cost at the hash rate seen so far
+    uint32_t nextTargetBits = m_blockchain->getNextTargetBits();
+    Hash256 nextTarget;
+    double nextExpectedHashes = ahmiyat::utils::compactToTarget(nextTargetBits, nextTarget)
+                              ? MiningTelemetry::expectedHashes(nextTarget) : 0.0;
+
+    json result;
+    result["blocksFound"] = stats.blocksFound;
+    result["searchesCancelled"] = stats.searchesCancelled;
+    result["searchesFailed"] = stats.searchesFailed;
+    result["totalHashes"] = stats.totalHashes;
+    result["totalSeconds"] = stats.totalSeconds;
+    result["averageHashRate"] = stats.averageHashRate;
+    result["lastHashRate"] = stats.lastHashRate;
+    result["lastThreadHashRates"] = stats.lastThreadHashRates;
+    result["minSolveSeconds"] = stats.minSolveSeconds;
+    result["maxSolveSeconds"] = stats.maxSolveSeconds;
+    result["meanSolveSeconds"] = stats.meanSolveSeconds;
+    result["solveTimeHistogram"] = histogram;
+    result["meanHashesPerBlock"] = stats.meanHashesPerBlock;
+    result["meanExpectedHashesPerBlock"] = stats.meanExpectedHashesPerBlock;
+    result["nextTargetBits"] = nextTargetBits;
+    result["nextExpectedHashes"] = nextExpectedHashes;
+    result["nextExpectedSeconds"] = stats.averageHashRate > 0.0 ? nextExpectedHashes / stats.averageHashRate : 0.0;
 
     return HttpResponse(200, "application/json", result.dump());
 }
@@ -553,6 +738,24 @@ HttpResponse AhmiyatWebApp::handleGetBlockchain(const HttpRequest& req) {
     return HttpResponse(200, "application/json", json);
 }
 
+HttpResponse AhmiyatWebApp::handleBlockCacheStats(const HttpRequest& req) {
+    BlockCacheStats stats = m_blockchain->getBlockCacheStats();
+    uint64_t lookups = stats.hits + stats.misses;
+
+    json result;
+    result["hits"] = stats.hits;
+    result["misses"] = stats.misses;
+    result["hitRate"] = lookups > 0 ? static_cast<double>(stats.hits) / lookups : 0.0;
+    result["evictions"] = stats.evictions;
+    result["cachedBlocks"] = stats.size;
+    result["capacity"] = stats.capacity;
+    result["chainSize"] = m_blockchain->getChainSize();
+    result["prunedHeight"] = m_blockchain->getPrunedHeight();
+    result["pruneDepth"] = m_blockchain->getPruneDepth();
+
+    return HttpResponse(200, "application/json", result.dump());
+}
+
 HttpResponse AhmiyatWebApp::handleStaticFiles(const HttpRequest& req) {
     std::string path = extractStaticFilePath(req.uri);
 
@@ -16,8 +16,9 @@ int main(int argc, char* argv[]) {
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
 
-    // Default port is 5000
+    // Default port is 5000; every block body is kept unless --prune is given
     int port = 5000;
+    size_t pruneDepth = Blockchain::NO_PRUNING;
     
     // Parse command line arguments
     for (int i = 1; i < argc; ++i) {
@@ -25,11 +26,20 @@ int main(int argc, char* argv[]) {
         if (arg == "--port" && i + 1 < argc) {
             port = std::stoi(argv[i + 1]);
             i++;
+        } else if (arg == "--prune" && i + 1 < argc) {
+            try {
+                pruneDepth = std::stoul(argv[i + 1]);
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid prune depth: " << argv[i + 1] << std::endl;
+                std::cerr << "Usage: " << argv[0] << " [--port <port>] [--prune <depth>]" << std::endl;
+                return 1;
+            }
+            i++;
         }
     }
     
     // Create the web application
-    ahmiyat::web::AhmiyatWebApp app(port);
+    ahmiyat::web::AhmiyatWebApp app(port, pruneDepth);
     g_app = &app;
     
     // Print welcome message
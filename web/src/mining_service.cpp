@@ -0,0 +1,268 @@
+#include "../include/mining_service.h"
+#include <iostream>
+
+namespace ahmiyat {
+namespace web {
+
+std::string miningJobStateToString(MiningJobState state) {
+    switch (state) {
+        case MiningJobState::QUEUED: return "queued";
+        case MiningJobState::RUNNING: return "running";
+        case MiningJobState::SUCCEEDED: return "succeeded";
+        case MiningJobState::FAILED: return "failed";
+        case MiningJobState::CANCELLED: return "cancelled";
+        default: return "unknown";
+    }
+}
+
+MiningService::MiningService(std::shared_ptr<Blockchain> blockchain, size_t threadCount)
+    : m_blockchain(std::move(blockchain)),
+      m_threadCount(threadCount),
+      m_running(false),
+      m_nextJobId(1),
+      m_currentHashes(0),
+      m_cancelCurrent(false) {
+}
+
+MiningService::~MiningService() {
+    stop();
+}
+
+void MiningService::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return;
+    }
+
+    m_running = true;
+    m_worker = std::thread(&MiningService::workerLoop, this);
+}
+
+void MiningService::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+
+        // Queued jobs will never run; the running one stops at its next batch
+        while (!m_queue.empty()) {
+            finishJob(m_jobs[m_queue.front()], MiningJobState::CANCELLED, "Mining service stopped");
+            m_queue.pop_front();
+        }
+        m_cancelCurrent.store(true);
+    }
+
+    m_condition.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+std::string MiningService::submit(const std::string& minerAddress) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // One active job per address; repeated clicks return the same job
+    auto latest = m_latestJobs.find(minerAddress);
+    if (latest != m_latestJobs.end()) {
+        auto existing = m_jobs.find(latest->second);
+        if (existing != m_jobs.end() && existing->second.isActive()) {
+            return existing->first;
+        }
+    }
+
+    MiningJob job;
+    job.id = "job-" + std::to_string(m_nextJobId++);
+    job.minerAddress = minerAddress;
+    job.submitted = std::chrono::steady_clock::now();
+
+    if (!m_running) {
+        finishJob(job, MiningJobState::FAILED, "Mining service is not running");
+    } else {
+        m_queue.push_back(job.id);
+    }
+
+    m_latestJobs[minerAddress] = job.id;
+    std::string id = job.id;
+    m_jobs.emplace(id, std::move(job));
+
+    m_condition.notify_one();
+    return id;
+}
+
+bool MiningService::getJob(const std::string& id, MiningJob& job) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_jobs.find(id);
+    if (it == m_jobs.end()) {
+        return false;
+    }
+
+    job = snapshot(it->second);
+    return true;
+}
+
+bool MiningService::getLatestJob(const std::string& minerAddress, MiningJob& job) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto latest = m_latestJobs.find(minerAddress);
+    if (latest == m_latestJobs.end()) {
+        return false;
+    }
+
+    auto it = m_jobs.find(latest->second);
+    if (it == m_jobs.end()) {
+        return false;
+    }
+
+    job = snapshot(it->second);
+    return true;
+}
+
+bool MiningService::cancel(const std::string& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_jobs.find(id);
+    if (it == m_jobs.end() || !it->second.isActive()) {
+        return false;
+    }
+
+    if (it->second.state == MiningJobState::QUEUED) {
+        for (auto queued = m_queue.begin(); queued != m_queue.end(); ++queued) {
+            if (*queued == id) {
+                m_queue.erase(queued);
+                break;
+            }
+        }
+        finishJob(it->second, MiningJobState::CANCELLED, "Cancelled");
+    } else if (id == m_currentJob) {
+        // The worker records the cancellation once the miner returns
+        m_cancelCurrent.store(true);
+    }
+
+    return true;
+}
+
+void MiningService::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true) {
+        m_condition.wait(lock, [this]() { return !m_running || !m_queue.empty(); });
+        if (!m_running) {
+            break;
+        }
+
+        std::string id = m_queue.front();
+        m_queue.pop_front();
+
+        MiningJob& job = m_jobs[id];
+        job.state = MiningJobState::RUNNING;
+        job.started = std::chrono::steady_clock::now();
+        std::string minerAddress = job.minerAddress;
+
+        m_currentJob = id;
+        m_currentHashes.store(0);
+        m_cancelCurrent.store(false);
+
+        // Mine without the service lock so status queries stay responsive
+        lock.unlock();
+        runJob(id, minerAddress);
+        lock.lock();
+
+        m_currentJob.clear();
+    }
+}
+
+void MiningService::runJob(const std::string& id, const std::string& minerAddress) {
+    MiningJobState state = MiningJobState::FAILED;
+    std::string message;
+    Block block;
+
+    for (uint32_t attempt = 0; attempt <= MAX_STALE_RETRIES; ++attempt) {
+        if (m_cancelCurrent.load()) {
+            state = MiningJobState::CANCELLED;
+            message = "Cancelled";
+            break;
+        }
+
+        // The template is a copy of the pending transactions and chain tip;
+        // the chain lock is held only while it is taken and when it is submitted
+        if (!m_blockchain->createBlockTemplate(minerAddress, block)) {
+            message = "Miner doesn't have enough memories to mine a block";
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs[id].templates++;
+        }
+
+        if (!m_blockchain->mineBlockTemplate(block, minerAddress, m_threadCount, &m_cancelCurrent, &m_currentHashes)) {
+            if (m_cancelCurrent.load()) {
+                state = MiningJobState::CANCELLED;
+                message = "Cancelled";
+            } else {
+                message = "No valid nonce found for the block template";
+            }
+            break;
+        }
+
+        if (m_blockchain->submitBlock(block)) {
+            state = MiningJobState::SUCCEEDED;
+            break;
+        }
+
+        // A rejected block that still extends the tip is invalid, not stale
+        if (m_blockchain->getLatestHeader().getHash() == block.getPreviousHash()) {
+            message = "Mined block was rejected";
+            break;
+        }
+
+        message = "Chain advanced while mining; template went stale";
+        std::cerr << "Mining job " << id << ": stale template, retrying" << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MiningJob& job = m_jobs[id];
+    job.hashesTried = m_currentHashes.load();
+    if (state == MiningJobState::SUCCEEDED) {
+        job.blockIndex = block.getIndex();
+        job.blockHash = block.getHash().toHex();
+        message.clear();
+    }
+    finishJob(job, state, message);
+}
+
+void MiningService::finishJob(MiningJob& job, MiningJobState state, const std::string& message) {
+    // Callers hold m_mutex
+    job.state = state;
+    job.message = message;
+    job.finished = std::chrono::steady_clock::now();
+
+    m_finished.push_back(job.id);
+    while (m_finished.size() > MAX_FINISHED_JOBS) {
+        const std::string& oldest = m_finished.front();
+        auto latest = m_jobs.find(oldest);
+        if (latest != m_jobs.end()) {
+            auto owner = m_latestJobs.find(latest->second.minerAddress);
+            if (owner != m_latestJobs.end() && owner->second == oldest) {
+                m_latestJobs.erase(owner);
+            }
+            m_jobs.erase(latest);
+        }
+        m_finished.pop_front();
+    }
+}
+
+MiningJob MiningService::snapshot(const MiningJob& job) const {
+    // Callers hold m_mutex
+    MiningJob copy = job;
+    if (job.state == MiningJobState::RUNNING && job.id == m_currentJob) {
+        copy.hashesTried = m_currentHashes.load(std::memory_order_relaxed);
+    }
+    return copy;
+}
+
+} // namespace web
+} // namespace ahmiyat
@@ -159,35 +159,37 @@ void SimpleHttpServer::handleClient(int client_socket) {
     // Find a matching route
     HttpResponse response(404, "text/plain", "Not Found");
     
+    // The route table is only locked for the lookup; handlers run
+    // concurrently so a slow request does not stall every other client
+    HttpHandler handler;
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        bool routeFound = false;
         
         // First try exact match
         for (const auto& route : m_routes) {
             if (route.method == request.method && route.path == request.uri) {
-                response = route.handler(request);
-                routeFound = true;
+                handler = route.handler;
                 break;
             }
         }
         
         // If not found, try prefix match for static files
-        if (!routeFound && request.method == HttpMethod::GET) {
+        if (!handler && request.method == HttpMethod::GET) {
             for (const auto& route : m_routes) {
                 // Check if the route is a static file route and URI starts with it
                 if (route.path == "/public" && request.uri.find("/public/") == 0) {
-                    response = route.handler(request);
-                    routeFound = true;
+                    handler = route.handler;
                     break;
                 }
             }
         }
-        
+    }
+    
+    if (handler) {
+        response = handler(request);
+    } else {
         // Add debug info
-        if (!routeFound) {
-            std::cerr << "No route found for: " << methodToString(request.method) << " " << request.uri << std::endl;
-        }
+        std::cerr << "No route found for: " << methodToString(request.method) << " " << request.uri << std::endl;
     }
     
     // Build the response
@@ -212,6 +214,14 @@ HttpRequest SimpleHttpServer::parseRequest(const std::string& request_str) {
         request_line >> method_str >> uri >> version;
         
         request.method = stringToMethod(method_str);
+        
+        // Split off the query string before decoding so encoded '?' and
+        // '&' characters in values survive
+        size_t query_pos = uri.find('?');
+        if (query_pos != std::string::npos) {
+            parseQuery(uri.substr(query_pos + 1), request.query);
+            uri.erase(query_pos);
+        }
         request.uri = uri;
         
         // URL-decode the URI
@@ -295,12 +305,14 @@ std::string SimpleHttpServer::statusCodeToString(int status_code) {
     switch (status_code) {
         case 200: return "OK";
         case 201: return "Created";
+        case 202: return "Accepted";
         case 204: return "No Content";
         case 400: return "Bad Request";
         case 401: return "Unauthorized";
         case 403: return "Forbidden";
         case 404: return "Not Found";
         case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
         case 500: return "Internal Server Error";
         case 501: return "Not Implemented";
         case 503: return "Service Unavailable";
@@ -332,5 +344,24 @@ void SimpleHttpServer::urlDecode(std::string& text) {
     text = result;
 }
 
+void SimpleHttpServer::parseQuery(const std::string& queryString, std::unordered_map<std::string, std::string>& query) {
+    std::istringstream stream(queryString);
+    std::string pair;
+    
+    while (std::getline(stream, pair, '&')) {
+        if (pair.empty()) {
+            continue;
+        }
+        
+        size_t equals_pos = pair.find('=');
+        std::string name = pair.substr(0, equals_pos);
+        std::string value = equals_pos != std::string::npos ? pair.substr(equals_pos + 1) : "";
+        
+        urlDecode(name);
+        urlDecode(value);
+        query[name] = value;
+    }
+}
+
 } // namespace web
 } // namespace ahmiyat
\ No newline at end of file